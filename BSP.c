@@ -10,6 +10,8 @@
 
 #include "Can.h"
 #include "Flash.h"
+#include "IsoTp.h"
+#include "Packet.h"
 #include "Usart1.h"
 #include "Spi.h"
 #include "BSP.h"
@@ -23,11 +25,15 @@ static tBSPStruct gIF;
 static void TorqueSensorCoreClockInit(void);
 static void WatchdogCoreClockInit(void);
 static void WatchdogGPIOInit(void);
+static void BootVectorsInit(void);
+static void ReadyGPIOInit(void);
+static void ReadySet(const uint8_t ready);
 /******************************************************************************/
 /**
 * tBSPStruct* BSP_Init(void)
 * @brief Initialize target based bsp options
-* @returns pointer to structure with which protocol state machine can work
+* @returns pointer to structure with which protocol state machine can work,
+*          InitStatus is not eFunction_Ok if the interface could not be initialized
 *
 *******************************************************************************/
 tBSPStruct* BSP_Init(void)
@@ -37,12 +43,22 @@ tBSPStruct* BSP_Init(void)
     gIF.pInit           = NULL;
     gIF.pSend           = NULL;
     gIF.pRecv           = NULL;
+    gIF.pRecvChecked    = NULL;
     gIF.pReset          = NULL;
+    gIF.pReady          = &ReadySet;
 
     gIF.BootTimeoutTicks= BootTIMEOUT;
     gIF.AppStartTicks   = BootTIMEOUT - 100000UL;
     gIF.CommDoneTicks   = 10000UL;
     gIF.TwoBytesTicks   = 300UL;
+    /* Receive interrupts keep taking bytes during flash programming, so the whole window may be in flight
+     * as far as the packets fit into the receive buffer of the interface */
+#if defined(SELECT_WINDOW)
+    gIF.WindowSize      = PACKET_WINDOW_SIZE;
+#else
+    gIF.WindowSize      = 1U;
+#endif
+    gIF.RxBufferSize    = BSP_RX_RING_SIZE;
 
 
 /*
@@ -77,13 +93,26 @@ tBSPStruct* BSP_Init(void)
     gIF.BSP_Type = BSP_CAN;
 
     gIF.pInit   = &CanInit;
+#if defined (SELECT_ISOTP)
+    gIF.pRecv   = &IsoTpRecv;
+    gIF.pSend   = &IsoTpSend;
+    gIF.pReset  = &IsoTpReset;
+    /* The ring keeps whole frames with their length, a consecutive frame carries 7 bytes */
+    gIF.RxBufferSize = (BSP_RX_RING_SIZE / (CAN_MAX_DATA_LENGTH + 1U)) * (CAN_MAX_DATA_LENGTH - 1U);
+#else
     gIF.pRecv   = &CanRecv;
     gIF.pSend   = &CanSend;
     gIF.pReset  = &CanReset;
+#endif
+    /* Blocks in data frames with 29 bit ID, checked by the CAN controller */
+    gIF.pRecvChecked = &CanRecvBlock;
 
 #elif defined (SELECT_WATCHDOG)
 
     #warning Watchdog (SPI) selected
+
+    gIF.BSP_Type = BSP_ExtWatchdog;
+
     WatchdogCoreClockInit();
     WatchdogGPIOInit();
     
@@ -91,6 +120,7 @@ tBSPStruct* BSP_Init(void)
     gIF.pRecv   = &SpiRecv;
     gIF.pSend   = &SpiSend;
     gIF.pReset  = &SpiReset;
+    gIF.pRecvChecked = &SpiRecvChecked;
 
 #else
 
@@ -172,6 +202,7 @@ tBSPStruct* BSP_Init(void)
             gIF.pRecv   = &SpiRecv;
             gIF.pSend   = &SpiSend;
             gIF.pReset  = &SpiReset;
+            gIF.pRecvChecked = &SpiRecvChecked;
             break;
 
         case BSP_CAN:
@@ -217,7 +248,14 @@ tBSPStruct* BSP_Init(void)
     gIF.BootTimeoutTicks  *= temp_u32;
     gIF.TwoBytesTicks     *= temp_u32;
     
-    gIF.pInit(gIF.BSP_Type);
+    BootVectorsInit();
+    ReadyGPIOInit();
+    /* Nothing can be received without the interface, main then only starts the application */
+    gIF.InitStatus = eFunction_Error;
+    if(gIF.pInit != NULL)
+    {
+        gIF.InitStatus = gIF.pInit(gIF.BSP_Type);
+    }
     
     FlashInit(gIF.BSP_Type);
     
@@ -328,3 +366,70 @@ void WatchdogGPIOInit(void)
 
 }
 
+/******************************************************************************/
+/**
+void BootVectorsInit(void)
+* @brief copy the bootloader vectors to the start of SRAM and map SRAM at
+* address 0, so the receive interrupts are served while flash is busy. The
+* application vectors replace them before the jump to the application.
+*
+*******************************************************************************/
+void BootVectorsInit(void)
+{
+    volatile uint32_t *pFlash = (volatile uint32_t *)BSP_ABSOLUTE_FLASH_START;
+    volatile uint32_t *pRAM   = (volatile uint32_t *)BSP_ABSOLUTE_SRAM_START;
+
+    for(uint32_t i = 0U; i < BSP_APP_VECTOR_SIZE_WORDS; i++)
+    {
+        pRAM[i] = pFlash[i];
+    }
+    RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN;
+    SYSCFG->CFGR1 |= SYSCFG_CFGR1_MEM_MODE;
+}
+
+/******************************************************************************/
+/**
+void ReadyGPIOInit(void)
+* @brief configure the optional ready/busy output as push-pull output, the
+* bootloader is ready for commands after start up
+*
+*******************************************************************************/
+void ReadyGPIOInit(void)
+{
+#if defined(BSP_READY_PIN)
+    RCC->AHBENR |= RCC_AHBENR_GPIOAEN | RCC_AHBENR_GPIOBEN;
+
+    BSP_READY_PORT->BSRR    =  (1UL << BSP_READY_PIN);
+    BSP_READY_PORT->MODER   &= ~((3UL << 2*BSP_READY_PIN));
+    BSP_READY_PORT->MODER   |=  ((1UL << 2*BSP_READY_PIN));
+    BSP_READY_PORT->OTYPER  &= ~((1UL <<   BSP_READY_PIN));
+    BSP_READY_PORT->OSPEEDR |=  ((3UL << 2*BSP_READY_PIN));
+    BSP_READY_PORT->PUPDR   &= ~((3UL << 2*BSP_READY_PIN));
+#endif
+}
+
+/******************************************************************************/
+/**
+void ReadySet(const uint8_t ready)
+* @brief drive the optional ready/busy output
+* @param[in] ready 0 while busy with flash, BSP_READY_RELEASE to return the pin
+*            to input, otherwise ready for the next packet
+*
+*******************************************************************************/
+void ReadySet(const uint8_t ready)
+{
+#if defined(BSP_READY_PIN)
+    if(ready == BSP_READY_RELEASE)
+    {
+        BSP_READY_PORT->MODER   &= ~((3UL << 2*BSP_READY_PIN));
+        BSP_READY_PORT->OSPEEDR &= ~((3UL << 2*BSP_READY_PIN));
+        BSP_READY_PORT->BSRR    =  (1UL << (BSP_READY_PIN + 16U));
+    }else if(ready != 0U)
+    {
+        BSP_READY_PORT->BSRR = (1UL << BSP_READY_PIN);
+    }else
+    {
+        BSP_READY_PORT->BSRR = (1UL << (BSP_READY_PIN + 16U));
+    }
+#endif
+}
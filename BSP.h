@@ -29,17 +29,22 @@
 
 /** Constants related to SRAM in the µC */
 #define BSP_ABSOLUTE_SRAM_START             (0x20000000UL)  /** Start address of SRAM */
+/** Functions which are copied to SRAM at start up (section RAMCODE in BootSlave.sct), code
+ *  fetch from flash stalls while the flash controller erases or programs */
+#define BSP_RAMFUNC                         __attribute__((section("RAMCODE")))
 
 /** Constants related to relocation of interrupt vectors of application in SRAM */
 #define BSP_APP_VECTOR_SIZE_BYTES           (0x000000C0UL)
 #define BSP_APP_VECTOR_SIZE_WORDS           (BSP_APP_VECTOR_SIZE_BYTES / sizeof(uint32_t))
 
 /** Constants related to Bootloader in program flash */
-/** Maximum allowed size of Bootloader */
-#define BSP_BOOTLOADER_MAX_SIZE             (0x1000UL)
+/** Maximum allowed size of Bootloader, the same size as ER_IROM1 in BootSlave.sct. The
+ *  bootloader has grown beyond 4kB, applications linked for 0x08001000 have to be linked
+ *  again for the new start before they can be loaded */
+#define BSP_BOOTLOADER_MAX_SIZE             (0x3000UL)
 
 /** Constants related to Application in program flash */
-/** The start of any application is always fixed in flash at 0x08001000UL */
+/** The start of any application is always fixed in flash at 0x08003000UL */
 #define BSP_ABSOLUTE_APP_START              (BSP_ABSOLUTE_FLASH_START + BSP_BOOTLOADER_MAX_SIZE)
 
 /** Constants related to Pilot(UID) STM32F031G4U6 with 16kB flash */
@@ -47,7 +52,7 @@
 #define BSP_FLASH_MAX_SIZE_16KB             (0x4000UL)
 /** End of Flash address in STM32F031G4U6 */
 #define BSP_ABSOLUTE_FLASH_END_16KB         (0x08004000UL)
-/** Total flash sectors to be erased in 16kB flash for application space (0x0C)*/
+/** Total flash sectors to be erased in 16kB flash for application space (0x04)*/
 #define BSP_APP_PROGRAM_PAGES_16KB          ((BSP_FLASH_MAX_SIZE_16KB - BSP_BOOTLOADER_MAX_SIZE) / BSP_FLASH_PAGE_SIZE_BYTES)
 
 /** Constants related to other targets using STM32F031G6U6 and STM32F042K6U6 with 32kB flash */
@@ -55,7 +60,7 @@
 #define BSP_FLASH_MAX_SIZE_32KB             (0x8000UL)
 /** End of Flash address in STM32F031G6U6 and STM32F042K6U6 */
 #define BSP_ABSOLUTE_FLASH_END_32KB         (0x08008000UL)
-/** Total flash sectors to be erased in 32kb flash for application space (0x1C) */
+/** Total flash sectors to be erased in 32kb flash for application space (0x14) */
 #define BSP_APP_PROGRAM_PAGES_32KB          ((BSP_FLASH_MAX_SIZE_32KB - BSP_BOOTLOADER_MAX_SIZE) / BSP_FLASH_PAGE_SIZE_BYTES)
 
 /** Constants for interfaces */
@@ -77,6 +82,15 @@
 #define BSP_TARGET_CAN_RX_PIN               (11U)
 #define BSP_TARGET_CAN_BAUD                 (500000U)
 #define BSP_TARGET_CAN_ID_BASE              (8U)
+/** APB clock of the CAN target the bit timing is calculated for, HSI without PLL */
+#define BSP_TARGET_CAN_PCLK_HZ              (8000000UL)
+/** Shared ID of all nodes of a group, frames to the group are not answered */
+#define BSP_TARGET_CAN_GROUP_ID             (0x7FU)
+/** ID of the enumeration requests, nodes take the address the host assigns, see CanInit */
+#define BSP_TARGET_CAN_ENUM_ID              (0x7EU)
+/** 96 bit unique ID of the device */
+#define BSP_UID_BASE                        (0x1FFFF7ACUL)
+#define BSP_UID_SIZE_BYTES                  (12U)
 
 /** Interface Ports, Pins and configuration in targets for SPI bus communication */
 #define BSP_TARGET_SPI_PORT                 (GPIOA)
@@ -86,6 +100,10 @@
 #define BSP_TARGET_SPI_MISO_PIN             (6U)
 #define BSP_TARGET_SPI_MOSI_PIN             (7U)
 
+/** Bytes buffered by the receive interrupt of the interfaces, power of two. Only the interrupts
+ *  and DMA receive while a page is erased, so a packet received through the ring is limited to it */
+#define BSP_RX_RING_SIZE                    (256U)
+
 //#define BSP_TARGET_SPI_PORT                 (GPIOB)
 //#define BSP_TARGET_SPI_NSS_PORT             (GPIOA)
 //#define BSP_TARGET_SPI_NSS_PIN              (15U)
@@ -93,6 +111,13 @@
 //#define BSP_TARGET_SPI_MISO_PIN             (4U)
 //#define BSP_TARGET_SPI_MOSI_PIN             (5U)
 
+/** Optional ready/busy output to the host, high while the next packet is accepted and low
+ *  while it is written to flash. Define the pin if the line is connected */
+//#define BSP_READY_PORT                      (GPIOA)
+//#define BSP_READY_PIN                       (1U)
+/** pReady value which returns the ready/busy pin to its reset state before the application starts */
+#define BSP_READY_RELEASE                   (2U)
+
 #define BSP_CHECK_PORT                      (GPIOA)
 #define BSP_CHECK_PIN_6                     (6U)
 #define BSP_CHECK_PIN_7                     (7U)
@@ -113,14 +138,19 @@ typedef enum bsptype {
 
 typedef struct  {
     tBSPType BSP_Type;
-    void (*pInit)(const tBSPType);
+    eFUNCTION_RETURN InitStatus;
+    eFUNCTION_RETURN (*pInit)(const tBSPType);
     void (*pSend)(uint8_t *, uint16_t);
     eFUNCTION_RETURN (*pRecv)(uint8_t *, uint16_t);
+    eFUNCTION_RETURN (*pRecvChecked)(uint8_t *, uint16_t);
     void (*pReset)(void);
+    void (*pReady)(const uint8_t);
     uint32_t BootTimeoutTicks;
     uint32_t AppStartTicks;
     uint32_t CommDoneTicks;
     uint32_t TwoBytesTicks;
+    uint16_t WindowSize;
+    uint16_t RxBufferSize;
 }tBSPStruct;
 /* ***************** Global data declarations ( extern ) **********************/
 /* ***** External parameter / constant declarations ( extern const ) **********/
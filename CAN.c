@@ -9,7 +9,10 @@
 
 #include <stddef.h>
 
+#include "Command.h"
 #include "Gpio.h"
+#include "Packet.h"
+#include "Ring.h"
 
 #include "Can.h"
 
@@ -22,19 +25,61 @@
 /* ***************** Modul global data segment ( static ) *********************/
 /* *************** Modul global constants ( static const ) ********************/
 /* **************** Local func/proc prototypes ( static ) *********************/
-static uint16_t index = 0U;
+static tRing    RxRing;
+static uint8_t  RxBuffer[BSP_RX_RING_SIZE];
+static tCANFrame TxQueue[CAN_TX_QUEUE_SIZE];
+static volatile uint8_t TxHead = 0U;
+static volatile uint8_t TxTail = 0U;
 static uint32_t TxPin = 0UL;
 static uint32_t RxPin = 0UL;
 static GPIO_TypeDef *pGPIO_CAN = NULL;
+static uint8_t  *pBlock = NULL;                      /** Block the data frames are placed in */
+static uint16_t BlockFrames = 0U;                   /** Frames of the block */
+static volatile uint16_t BlockNumber = 0U;          /** Block number of the frames received */
+static volatile uint16_t BlockReceived = 0U;        /** Frames of the block received */
+static uint32_t BlockMap[CAN_EXT_FRAMES_MAX / 32U]; /** Received frames of the block */
+static volatile uint8_t GroupAddressed = 0U;        /** Last command came to the group */
+static uint32_t NodeId = BSP_TARGET_CAN_ID_BASE;    /** Our ID, the host may assign another */
+#if defined(SELECT_ENUM)
+static uint8_t  NodeAssigned = 0U;                  /** The host assigned our ID */
+static uint8_t  EnumRunning = 0U;                   /** Still in the enumeration round */
+static uint32_t EnumChunk = 0UL;                    /** Bits of our unique ID in this round */
+#endif
+static BSP_RAMFUNC void CanTxService(void);
+static BSP_RAMFUNC uint8_t CanQueue(const tCANData *pTxData, const uint32_t id, const uint32_t length);
+static BSP_RAMFUNC void CanNodeFilter(void);
+#if defined(SELECT_ENUM)
+static BSP_RAMFUNC void CanEnumerate(const tCANData *pRxData, const uint32_t length);
+#endif
 /******************************************************************************/
 /**
-* void CanInit(void)
+* eFUNCTION_RETURN CanInit(tBSPType BSPType)
 * @brief Configure CAN
 *
+* @param[in] BSPType The type of target to be configured according to BSP
+* @returns   eFunction_Ok if CAN takes part in bus communication
+*            or
+*            eFunction_Error if the peripheral clock does not match the bit timing
+*            or
+*            eFunction_Timeout if the controller does not change its mode.
+*
 *******************************************************************************/
-void CanInit(tBSPType BSPType)
+eFUNCTION_RETURN CanInit(tBSPType BSPType)
 {
     uint32_t canWait;
+    uint32_t pclk;
+
+    /** The bit timing is fixed at compile time, a bus with wrong timing would be disturbed */
+    SystemCoreClockUpdate();
+    pclk = SystemCoreClock;
+    if((RCC->CFGR & RCC_CFGR_PPRE_2) != 0U)
+    {
+        pclk >>= ((RCC->CFGR & RCC_CFGR_PPRE) >> 8U) - 3U;
+    }
+    if(pclk != BSP_TARGET_CAN_PCLK_HZ)
+    {
+        return eFunction_Error;        /** Return if CAN is clocked with another frequency */
+    }
 
     RCC->AHBENR |= RCC_AHBENR_GPIOAEN;
 
@@ -77,30 +122,41 @@ void CanInit(tBSPType BSPType)
     {
         if(!(canWait--))
         {
-            return;        /** Return if the busy wait timer expires todo needs a proper error code */
+            return eFunction_Timeout;        /** Return if the busy wait timer expires */
         }
     }
-    /** Exit sleep mode */
+    /** Exit sleep mode, transmit mailboxes in the order of the requests */
     CAN->MCR &= ~CAN_MCR_SLEEP;
-    #if (BSP_BASE_CAN_BAUD == 500000U)
-    #warning CAN bus baud: 500k
-    /** loopback mode set timing to 500kBaud: BS1 = 4, BS2 = 3, prescaler = 1 */
-    CAN->BTR = (2 << 20) | (3 << 16) | (1 << 0);
-    #else
-    #warning CAN bus baud: 1M
-    /** loopback mode set timing to 1MBaud: BS1 = 4, BS2 = 3, prescaler = 0 */
-    CAN->BTR = (2 << 20) | (3 << 16) | (0 << 0);
-    #endif
-    /** Activate filter 0 */
+    CAN->MCR |= CAN_MCR_TXFP;
+    /** Bit timing calculated for CAN_BAUD and BSP_TARGET_CAN_PCLK_HZ, see CAN_BTR_VALUE */
+    CAN->BTR = CAN_BTR_VALUE;
+    /** Filters 0 and 1 take the frames to our ID */
+    CanNodeFilter();
     CAN->FMR |= CAN_FMR_FINIT;
-    /** Set the ID and mask (all bits of std id care */
-    CAN->FA1R |= CAN_FA1R_FACT0;
-    /** Set the ID and the mask */
-    CAN->sFilterRegister[0].FR1 = (BSP_TARGET_CAN_ID_BASE << 5) | (0xFF70U <<16);
+#if defined(SELECT_MULTICAST)
+    /** Filter 2 takes the data frames to the group, all nodes of the group program the same stream */
+    CAN->FS1R |= CAN_FS1R_FSC2;
+    CAN->FA1R |= CAN_FA1R_FACT2;
+    CAN->sFilterRegister[2].FR1 = (CAN_EXT_ID(BSP_TARGET_CAN_GROUP_ID) << 3) | CAN_RI0R_IDE;
+    CAN->sFilterRegister[2].FR2 = (CAN_EXT_ID_MASK << 3) | CAN_RI0R_IDE;
+#endif
+#if defined(SELECT_ENUM)
+    /** Filter 3 takes the enumeration requests, filter 4 the answers of the other nodes */
+    CAN->FA1R |= CAN_FA1R_FACT3;
+    CAN->sFilterRegister[3].FR1 = (BSP_TARGET_CAN_ENUM_ID << 5) | (0xFFF8U <<16);
+    CAN->FS1R |= CAN_FS1R_FSC4;
+    CAN->FA1R |= CAN_FA1R_FACT4;
+    CAN->sFilterRegister[4].FR1 = ((uint32_t)CAN_ENUM_TAG << (CAN_EXT_TAG_POS + 3U)) | CAN_RI0R_IDE;
+    CAN->sFilterRegister[4].FR2 = (0x1FUL << (CAN_EXT_TAG_POS + 3U)) | CAN_RI0R_IDE;
+#endif
     /** Leave filter init */
     CAN->FMR &= ~CAN_FMR_FINIT;
-    /** Set FIFO0 message pending IT enabled */
+    /** Set FIFO0 message pending IT enabled, the interrupt fills the receive ring buffer */
+    RingInit(&RxRing, RxBuffer, BSP_RX_RING_SIZE);
     CAN->IER |= CAN_IER_FMPIE0;
+    /** Transmit mailbox empty IT refills the mailboxes from the transmit queue */
+    CAN->IER |= CAN_IER_TMEIE;
+    NVIC_EnableIRQ(CEC_CAN_IRQn);
     /** Come out of initialization */
     CAN->MCR &= ~CAN_MCR_INRQ;
     /** Wait until we exit init mode */
@@ -110,15 +166,19 @@ void CanInit(tBSPType BSPType)
     {
         if(!(canWait--))
         {
-            return;        /** Return if the busy wait timer expires */
+            NVIC_DisableIRQ(CEC_CAN_IRQn);
+            return eFunction_Timeout;        /** Return if the busy wait timer expires */
         }
     }
+
+    return eFunction_Ok;
 }
 
 /******************************************************************************/
 /**
 * void CanSend(uint8_t *pTxData, uint16_t size)
-* @brief Implement CAN send.
+* @brief Implement CAN send. The frames are queued and put into all three
+*        transmit mailboxes, the mailbox empty interrupt sends the rest.
 *
 * @param[in] pTxData pointer to the data to be transmitted
 * @param[in] size number of bytes
@@ -133,7 +193,6 @@ void CanSend(uint8_t *pTxData, uint16_t size)
     tCANData     TxData;
     uint16_t     tempindex = 0;
     uint16_t     loop8Bytes;
-    uint32_t     canWait;
 
     loop8Bytes = size / CAN_MAX_DATA_LENGTH;
 
@@ -155,65 +214,188 @@ void CanSend(uint8_t *pTxData, uint16_t size)
             TxData.Byte[i] = pTxData[tempindex++];
         }
 
-        /** Setup busy wait timer */
-        canWait = BootTIMEOUT;
-        while((CAN->TSR & CAN_TSR_TME0) == 0)
-        {
-            if(!(canWait--))
-            {
-                return;        /** Return if the busy wait timer expires */
-            }
-        }
-
-        CAN->sTxMailBox[0].TDLR = TxData.Word[0];
-        CAN->sTxMailBox[0].TDHR = TxData.Word[1];
+        CanSendFrame(&TxData, iLimit);
 
-        CAN->sTxMailBox[0].TIR = (BSP_TARGET_CAN_ID_BASE << 21);
-
-        CAN->sTxMailBox[0].TDTR &= ~CAN_TDT0R_DLC;
+        size -= iLimit;
+    }while(size);
+}
 
-        CAN->sTxMailBox[0].TDTR |= iLimit;
+/******************************************************************************/
+/**
+* void CanSendFrame(const tCANData *pTxData, const uint32_t length)
+* @brief Queue one frame with our ID for transmission. Only waits if the
+*        transmit queue is full. Commands to the group are not answered, all
+*        nodes would send at the same time.
+*
+* @param[in] pTxData pointer to the data of the frame
+* @param[in] length number of data bytes (DLC)
+*
+*******************************************************************************/
+void CanSendFrame(const tCANData *pTxData, const uint32_t length)
+{
+    uint32_t     canWait;
+    uint8_t      queued;
 
-        CAN->sTxMailBox[0].TIR |= CAN_TI0R_TXRQ;
-        /** Setup busy wait timer for transmission */
-        canWait = BootTIMEOUT;
-        while((CAN->TSR & CAN_TSR_RQCP0) == 0)
+    if(GroupAddressed != 0U)
+    {
+        return;
+    }
+    /** Setup busy wait timer, the interrupt empties the queue */
+    canWait = BootTIMEOUT;
+    do
+    {
+        /** The interrupt queues enumeration answers and fills the mailboxes, it must not run meanwhile */
+        NVIC_DisableIRQ(CEC_CAN_IRQn);
+        __DSB();
+        __ISB();
+        queued = CanQueue(pTxData, NodeId << 21, length);
+        NVIC_EnableIRQ(CEC_CAN_IRQn);
+        if(!(canWait--))
         {
-            if(!(canWait--))
-            {
-                return;        /** Return if the busy wait timer expires */
-            }
+            return;        /** Return if the busy wait timer expires */
         }
-
-        CAN->TSR |= CAN_TSR_RQCP0;
-
-        size -= iLimit;
-    }while(size);
+    }while(queued == 0U);
 }
 
 /******************************************************************************/
 /**
 * eFUNCTION_RETURN CanRecv(uint8_t *pRxData, const uint16_t size)
 *
-* @brief Read from CAN bus
+* @brief Read from CAN bus, takes all bytes received by the interrupt.
 *
 * @param[out] pRxData pointer to receive array buffer
 * @param[in]  size number of bytes to receive
 * @returns    eFunction_Ok if successful
 *             or
-*             eFunction_Error if data losts.
-*             or
-*             eFunction_Timeout if an timeout error occurs.
+*             eFunction_Timeout if more bytes are expected.
 *
 *******************************************************************************/
 eFUNCTION_RETURN CanRecv(uint8_t *pRxData, const uint16_t size)
 {
-    eFUNCTION_RETURN retVal = eFunction_Timeout;
-    uint32_t    temp32U = 0U;
+    return RingRead(&RxRing, pRxData, size);
+}
+
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN CanRecvFrame(tCANData *pRxData, uint32_t *pLength)
+*
+* @brief Take one received frame, only if frames are kept in the receive
+*        ring buffer (CAN_RING_FRAMES).
+*
+* @param[out] pRxData pointer to the data of the frame
+* @param[out] pLength number of data bytes (DLC)
+* @returns    eFunction_Ok if a frame is taken
+*             or
+*             eFunction_Timeout if no frame is received.
+*
+*******************************************************************************/
+eFUNCTION_RETURN CanRecvFrame(tCANData *pRxData, uint32_t *pLength)
+{
+    uint8_t length;
+
+    if(RingCount(&RxRing) == 0U)
+    {
+        return eFunction_Timeout;
+    }
+    /** The interrupt puts only complete frames into the ring buffer */
+    RingRead(&RxRing, &length, 1U);
+    pRxData->Word[0] = 0U;
+    pRxData->Word[1] = 0U;
+    if(length != 0U)
+    {
+        RingRead(&RxRing, pRxData->Byte, length);
+    }
+    *pLength = length;
+
+    return eFunction_Ok;
+}
+
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN CanRecvBlock(uint8_t *pRxData, uint16_t size)
+*
+* @brief Receive a block in data frames with 29 bit ID. The first call hands
+*        the buffer to the interrupt, which places each frame by its number.
+*        Frames of another block number restart the block, so the host may
+*        send a block again as long as it is not complete. A complete block
+*        is kept and further frames are dropped until it is taken, the caller
+*        hands over another buffer for the next block before it writes this
+*        one. The integrity of the frames is checked by the CAN controller,
+*        so the packet carries no sequence count and CRC.
+*
+* @param[out] pRxData pointer to the packet, the block number is returned as
+*             sequence count
+* @param[in]  size number of bytes of the packet, block plus PACKET_OVERHEAD
+* @returns    eFunction_Ok if all frames of the block are received
+*             or
+*             eFunction_Timeout if more frames are expected.
+*
+*******************************************************************************/
+eFUNCTION_RETURN CanRecvBlock(uint8_t *pRxData, uint16_t size)
+{
+    uint16_t frames = (size - PACKET_OVERHEAD) / CAN_MAX_DATA_LENGTH;
+
+    if((pBlock != pRxData) || (BlockFrames != frames))
+    {
+        CAN->IER &= ~CAN_IER_FMPIE0;
+        BlockFrames = frames;
+        BlockReceived = 0U;
+        BlockNumber = 0xFFFFU;
+        pBlock = pRxData;
+        CAN->IER |= CAN_IER_FMPIE0;
+        return eFunction_Timeout;
+    }
+    if(BlockReceived < BlockFrames)
+    {
+        return eFunction_Timeout;
+    }
+    /** Stop placing frames until the next block is requested */
+    pBlock = NULL;
+    PACKET_SEQCNT(pRxData, size - PACKET_OVERHEAD) = BlockNumber;
+
+    return eFunction_Ok;
+}
+
+/******************************************************************************/
+/**
+* void CanReset(void)
+*
+* @brief Reset receive pointer index and drop received bytes
+*
+* @returns    none
+*
+*******************************************************************************/
+inline void CanReset(void)
+{
+    RingFlush(&RxRing);
+    pBlock = NULL;
+}
+
+/******************************************************************************/
+/**
+* void CEC_CAN_IRQHandler(void)
+*
+* @brief FIFO0 message pending and transmit mailbox empty interrupt, runs from
+*        SRAM to take frames while flash is busy. The data bytes of frames with
+*        our ID are put into the receive ring buffer, data frames with 29 bit
+*        ID into the block of CanRecvBlock, all frames are released.
+*        Empty transmit mailboxes are refilled from the transmit queue.
+*
+*******************************************************************************/
+BSP_RAMFUNC void CEC_CAN_IRQHandler(void)
+{
+    uint32_t    temp32U;
     uint32_t    i;
-    tCANData     RxData;
+    tCANData    RxData;
+
+    /** A transmit mailbox became empty */
+    if((CAN->TSR & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2)) != 0U)
+    {
+        CAN->TSR = CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2;
+        CanTxService();
+    }
 
-    if((CAN->RF0R & CAN_RF0R_FMP0) != 0U)
+    while((CAN->RF0R & CAN_RF0R_FMP0) != 0U)
     {
         /** Read the FIFO */
         RxData.Word[0] = CAN->sFIFOMailBox[0].RDLR;
@@ -226,55 +408,246 @@ eFUNCTION_RETURN CanRecv(uint8_t *pRxData, const uint16_t size)
         {
             temp32U = CAN->sFIFOMailBox[0].RIR >> 3U;
         }
-        /** Check if ID is matching our ID */
-        if(temp32U != BSP_TARGET_CAN_ID_BASE)
+        /** Data frame of a block, placed by its frame number */
+        if(((CAN->sFIFOMailBox[0].RIR & CAN_RI0R_IDE) != 0) &&
+           (((temp32U & CAN_EXT_ID_MASK) == CAN_EXT_ID(NodeId)) ||
+            ((temp32U & CAN_EXT_ID_MASK) == CAN_EXT_ID(BSP_TARGET_CAN_GROUP_ID))))
         {
-            // retVal = eFunction_Error;
-        }else
+            i = temp32U & CAN_EXT_FRAME_MASK;
+            temp32U = (temp32U >> CAN_EXT_BLOCK_POS) & CAN_EXT_BLOCK_MASK;
+            /** A complete block stays until CanRecvBlock takes it, the frames meanwhile are dropped */
+            if((pBlock != NULL) && (BlockReceived < BlockFrames) && (i < BlockFrames) &&
+               ((CAN->sFIFOMailBox[0].RDTR & 0x000FU) == CAN_MAX_DATA_LENGTH))
+            {
+                if(temp32U != BlockNumber)
+                {
+                    BlockNumber = (uint16_t)temp32U;
+                    BlockReceived = 0U;
+                    for(temp32U = 0U; temp32U < (CAN_EXT_FRAMES_MAX / 32U); temp32U++)
+                    {
+                        BlockMap[temp32U] = 0U;
+                    }
+                }
+                if((BlockMap[i >> 5U] & (1UL << (i & 31U))) == 0U)
+                {
+                    BlockMap[i >> 5U] |= (1UL << (i & 31U));
+                    for(temp32U = 0U; temp32U < CAN_MAX_DATA_LENGTH; temp32U++)
+                    {
+                        pBlock[(i * CAN_MAX_DATA_LENGTH) + temp32U] = RxData.Byte[temp32U];
+                    }
+                    BlockReceived++;
+                }
+            }
+        }
+#if defined(SELECT_ENUM)
+        /** Answer of another node in the enumeration round */
+        else if((CAN->sFIFOMailBox[0].RIR & CAN_RI0R_IDE) != 0)
+        {
+            if((EnumRunning != 0U) && ((temp32U >> CAN_EXT_TAG_POS) == CAN_ENUM_TAG) &&
+               ((temp32U & CAN_ENUM_UID_MASK) < EnumChunk))
+            {
+                EnumRunning = 0U;
+            }
+        }
+        else if(temp32U == BSP_TARGET_CAN_ENUM_ID)
+        {
+            CanEnumerate(&RxData, CAN->sFIFOMailBox[0].RDTR & 0x000FU);
+        }
+#endif
+        /** Check if ID is matching our ID or the ID of the group */
+        else if((temp32U == NodeId) || (temp32U == BSP_TARGET_CAN_GROUP_ID))
         {
+            GroupAddressed = (temp32U == BSP_TARGET_CAN_GROUP_ID) ? 1U : 0U;
             /** Get the current message length from DLC [3:0] */
             temp32U = CAN->sFIFOMailBox[0].RDTR & 0x000FU;
-
             /** The number of bytes should not be more than 8 bytes */
-            if(temp32U <= CAN_MAX_DATA_LENGTH)
+            if(temp32U > CAN_MAX_DATA_LENGTH)
+            {
+                temp32U = CAN_MAX_DATA_LENGTH;
+            }
+#if defined(CAN_RING_FRAMES)
+            /** Keep the frame boundaries, the length is stored in front of the data */
+            if((BSP_RX_RING_SIZE - RingCount(&RxRing)) > temp32U)
             {
+                RingPut(&RxRing, (uint8_t)temp32U);
                 for(i = 0; i < temp32U; i++)
                 {
-                    pRxData[index] = RxData.Byte[i];
-                    index++;
-                    /** If we have received all expected bytes */
-                    if(index >= size)
-                    {
-                        /** Reset counter and exit successfully */
-                        index = 0;
-                        retVal = eFunction_Ok;
-                        break;
-                    }
+                    RingPut(&RxRing, RxData.Byte[i]);
                 }
-            }else
+            }
+#else
+            for(i = 0; i < temp32U; i++)
             {
-                retVal = eFunction_Error;
+                RingPut(&RxRing, RxData.Byte[i]);
             }
+#endif
         }
         /** Release FIFO */
         CAN->RF0R |= CAN_RF0R_RFOM0;
     }
+}
+
+/******************************************************************************/
+/**
+* uint8_t CanQueue(const tCANData *pTxData, const uint32_t id, const uint32_t length)
+*
+* @brief Put a frame into the transmit queue and fill the empty mailboxes.
+*        Called with the CAN interrupt disabled or by the interrupt.
+*
+* @param[in] pTxData pointer to the data of the frame
+* @param[in] id identifier as written to TIR
+* @param[in] length number of data bytes (DLC)
+* @returns   1 if the frame is queued, 0 if the queue is full
+*
+*******************************************************************************/
+static BSP_RAMFUNC uint8_t CanQueue(const tCANData *pTxData, const uint32_t id, const uint32_t length)
+{
+    tCANFrame   *pFrame;
 
-  return retVal;
+    if((uint8_t)(TxHead - TxTail) >= CAN_TX_QUEUE_SIZE)
+    {
+        return 0U;
+    }
+    pFrame = &TxQueue[TxHead & (CAN_TX_QUEUE_SIZE - 1U)];
+    pFrame->Data = *pTxData;
+    pFrame->Id = id;
+    pFrame->Length = length;
+    TxHead++;
+    CanTxService();
+
+    return 1U;
 }
 
 /******************************************************************************/
 /**
-* void CanReset(void)
+* void CanNodeFilter(void)
 *
-* @brief Reset receive pointer index
+* @brief Set filter 0 to the commands to our ID and to the group and filter 1
+*        to the data frames to our ID.
 *
-* @returns    none
+*******************************************************************************/
+static BSP_RAMFUNC void CanNodeFilter(void)
+{
+    CAN->FMR |= CAN_FMR_FINIT;
+    /** A filter may only be changed while it is not active */
+    CAN->FA1R &= ~(CAN_FA1R_FACT0 | CAN_FA1R_FACT1);
+    /** Set the ID and the mask */
+    CAN->sFilterRegister[0].FR1 = (NodeId << 5) | (0xFF70U <<16);
+    /** Second ID and mask of filter 0 for the commands to the group */
+    CAN->sFilterRegister[0].FR2 = (BSP_TARGET_CAN_GROUP_ID << 5) | (0xFF70U <<16);
+    /** Filter 1 takes the data frames with 29 bit ID for our node, any block and frame number */
+    CAN->FS1R |= CAN_FS1R_FSC1;
+    CAN->sFilterRegister[1].FR1 = (CAN_EXT_ID(NodeId) << 3) | CAN_RI0R_IDE;
+    CAN->sFilterRegister[1].FR2 = (CAN_EXT_ID_MASK << 3) | CAN_RI0R_IDE;
+    CAN->FA1R |= CAN_FA1R_FACT0 | CAN_FA1R_FACT1;
+    CAN->FMR &= ~CAN_FMR_FINIT;
+}
+
+#if defined(SELECT_ENUM)
+/******************************************************************************/
+/**
+* void CanEnumerate(const tCANData *pRxData, const uint32_t length)
+*
+* @brief Take part in an enumeration round or take the assigned address. A
+*        node which has an address assigned does not answer any more.
+*
+* @param[in] pRxData pointer to the data of the request
+* @param[in] length number of data bytes (DLC)
 *
 *******************************************************************************/
-inline void CanReset(void)
+static BSP_RAMFUNC void CanEnumerate(const tCANData *pRxData, const uint32_t length)
+{
+    const uint8_t *pUID = (const uint8_t *)BSP_UID_BASE;
+    tCANData    TxData;
+    uint32_t    round;
+    uint32_t    nodeId;
+
+    if((NodeAssigned != 0U) || (length == 0U))
+    {
+        return;
+    }
+    round = pRxData->Byte[0];
+    TxData.Word[0] = 0UL;
+    TxData.Word[1] = 0UL;
+    if(round == CAN_ENUM_ASSIGN)
+    {
+        /** Only the node which won all rounds takes the address */
+        if((EnumRunning != 0U) && (length >= 2U))
+        {
+            EnumRunning = 0U;
+            nodeId = pRxData->Byte[1] & 0x7FU;
+            /** The group and the enumeration ID can not be the address of a node,
+             *  the node keeps its address and takes part in the next enumeration */
+            if((nodeId == BSP_TARGET_CAN_GROUP_ID) || (nodeId == BSP_TARGET_CAN_ENUM_ID))
+            {
+                TxData.Word[0] = eRES_Error;
+            }else
+            {
+                NodeAssigned = 1U;
+                NodeId = nodeId;
+                CanNodeFilter();
+                TxData.Word[0] = eRES_OK;
+            }
+            CanQueue(&TxData, NodeId << 21, 2U);
+        }
+        return;
+    }
+    if(round >= CAN_ENUM_ROUNDS)
+    {
+        return;
+    }
+    /** All nodes without address start, in the following rounds only those which are left */
+    if(round == 0U)
+    {
+        EnumRunning = 1U;
+    }
+    if(EnumRunning != 0U)
+    {
+        EnumChunk = (uint32_t)pUID[3U * round] | ((uint32_t)pUID[(3U * round) + 1U] << 8U) |
+                    ((uint32_t)pUID[(3U * round) + 2U] << 16U);
+        /** Nodes with the same bits send the same frame, so the answers never collide */
+        CanQueue(&TxData, ((((uint32_t)CAN_ENUM_TAG << CAN_EXT_TAG_POS) | EnumChunk) << 3U) | CAN_TI0R_IDE, 0U);
+    }
+}
+#endif // SELECT_ENUM
+
+/******************************************************************************/
+/**
+* void CanTxService(void)
+*
+* @brief Move queued frames into the empty transmit mailboxes. Called by
+*        CanQueue and by the interrupt. The interrupt runs for received
+*        frames as well, so thread mode may only call it with CEC_CAN_IRQn
+*        disabled, otherwise both move TxTail and fill the same mailbox.
+*
+*******************************************************************************/
+static BSP_RAMFUNC void CanTxService(void)
 {
-    index = 0;
+    uint32_t    mailbox;
+    tCANFrame   *pFrame;
+
+    while(TxTail != TxHead)
+    {
+        if((CAN->TSR & CAN_TSR_TME0) != 0U)
+        {
+            mailbox = 0U;
+        }else if((CAN->TSR & CAN_TSR_TME1) != 0U)
+        {
+            mailbox = 1U;
+        }else if((CAN->TSR & CAN_TSR_TME2) != 0U)
+        {
+            mailbox = 2U;
+        }else
+        {
+            break;
+        }
+        pFrame = &TxQueue[TxTail & (CAN_TX_QUEUE_SIZE - 1U)];
+        CAN->sTxMailBox[mailbox].TDLR = pFrame->Data.Word[0];
+        CAN->sTxMailBox[mailbox].TDHR = pFrame->Data.Word[1];
+        CAN->sTxMailBox[mailbox].TDTR = pFrame->Length;
+        CAN->sTxMailBox[mailbox].TIR  = pFrame->Id | CAN_TI0R_TXRQ;
+        TxTail++;
+    }
 }
 
 #endif // SELECT_CAN
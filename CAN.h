@@ -21,6 +21,89 @@
 
 /* *************** Constant / macro definitions ( #define ) *******************/
 #define CAN_MAX_DATA_LENGTH        (8U)  // Maximum number of bytes in CAN bus (4H + 4L)
+#define CAN_TX_QUEUE_SIZE          (8U)  // Frames waiting for a free transmit mailbox, power of two
+#if defined(SELECT_ISOTP)
+#define CAN_RING_FRAMES                  // Receive ring buffer keeps frames for CanRecvFrame
+#endif
+/** Data frames with 29 bit identifier: tag [28:24], node [23:17], block number [16:7],
+ *  frame in the block [6:0]. All 8 bytes of a data frame are firmware, the frames of a block
+ *  are placed by their number in any order, see CanRecvBlock */
+#define CAN_EXT_TAG                (0x1BU)
+#define CAN_EXT_TAG_POS            (24U)
+#define CAN_EXT_NODE_POS           (17U)
+#define CAN_EXT_BLOCK_POS          (7U)
+#define CAN_EXT_BLOCK_MASK         (0x3FFU)
+#define CAN_EXT_FRAME_MASK         (0x7FU)
+#define CAN_EXT_ID(node)           ((CAN_EXT_TAG << CAN_EXT_TAG_POS) | (((node) & 0x7FU) << CAN_EXT_NODE_POS))
+#define CAN_EXT_ID_MASK            ((0x1FUL << CAN_EXT_TAG_POS) | (0x7FUL << CAN_EXT_NODE_POS))
+/** Frames of the largest block, one bit each */
+#define CAN_EXT_FRAMES_MAX         (CAN_EXT_FRAME_MASK + 1U)
+/** Enumeration: a request on BSP_TARGET_CAN_ENUM_ID with byte 0 = round 0..3 is answered by
+ *  each node without address with a frame of 29 bit ID tag [28:24] and 24 bits of its unique
+ *  ID [23:0], no data. Arbitration sorts the answers, a node which sees a lower answer drops
+ *  out, so after the last round one node is left. A request with byte 0 = CAN_ENUM_ASSIGN
+ *  gives it the address in byte 1, it confirms with eRES_OK from this address */
+#define CAN_ENUM_TAG               (0x1CU)
+#define CAN_ENUM_ROUNDS            (BSP_UID_SIZE_BYTES / 3U)
+#define CAN_ENUM_ASSIGN            (0x80U)
+#define CAN_ENUM_UID_MASK          (0x00FFFFFFUL)
+/** Bit timing: a bit is 1 + TS1 + TS2 time quanta of BSP_TARGET_CAN_PCLK_HZ / prescaler. The
+ *  most time quanta from 25 down to 8 are taken for which the prescaler is exact and the
+ *  sample point (1 + TS1) / quanta, rounded to CAN_SAMPLE_POINT per mille, fits TS1 and TS2 */
+#define CAN_BAUD                   (BSP_TARGET_CAN_BAUD)
+/** The sample point of the bus may be given in the project, all nodes have to use the same */
+#ifndef CAN_SAMPLE_POINT
+#define CAN_SAMPLE_POINT           (875UL)
+#endif
+#define CAN_BT_SJW                 (1UL)
+#define CAN_BT_TS1(tq)             (((((tq) * CAN_SAMPLE_POINT) + 500UL) / 1000UL) - 1UL)
+#define CAN_BT_TS2(tq)             ((tq) - 1UL - CAN_BT_TS1(tq))
+#define CAN_BT_PRESCALER(tq)       (BSP_TARGET_CAN_PCLK_HZ / (CAN_BAUD * (tq)))
+#define CAN_BT_OK(tq)              (((BSP_TARGET_CAN_PCLK_HZ % (CAN_BAUD * (tq))) == 0UL) && \
+                                    (CAN_BT_PRESCALER(tq) >= 1UL) && (CAN_BT_PRESCALER(tq) <= 1024UL) && \
+                                    (CAN_BT_TS1(tq) >= 1UL) && (CAN_BT_TS1(tq) <= 16UL) && \
+                                    (CAN_BT_TS2(tq) >= CAN_BT_SJW) && (CAN_BT_TS2(tq) <= 8UL))
+#if CAN_BT_OK(25UL)
+#define CAN_BT_TQ                  (25UL)
+#elif CAN_BT_OK(24UL)
+#define CAN_BT_TQ                  (24UL)
+#elif CAN_BT_OK(23UL)
+#define CAN_BT_TQ                  (23UL)
+#elif CAN_BT_OK(22UL)
+#define CAN_BT_TQ                  (22UL)
+#elif CAN_BT_OK(21UL)
+#define CAN_BT_TQ                  (21UL)
+#elif CAN_BT_OK(20UL)
+#define CAN_BT_TQ                  (20UL)
+#elif CAN_BT_OK(19UL)
+#define CAN_BT_TQ                  (19UL)
+#elif CAN_BT_OK(18UL)
+#define CAN_BT_TQ                  (18UL)
+#elif CAN_BT_OK(17UL)
+#define CAN_BT_TQ                  (17UL)
+#elif CAN_BT_OK(16UL)
+#define CAN_BT_TQ                  (16UL)
+#elif CAN_BT_OK(15UL)
+#define CAN_BT_TQ                  (15UL)
+#elif CAN_BT_OK(14UL)
+#define CAN_BT_TQ                  (14UL)
+#elif CAN_BT_OK(13UL)
+#define CAN_BT_TQ                  (13UL)
+#elif CAN_BT_OK(12UL)
+#define CAN_BT_TQ                  (12UL)
+#elif CAN_BT_OK(11UL)
+#define CAN_BT_TQ                  (11UL)
+#elif CAN_BT_OK(10UL)
+#define CAN_BT_TQ                  (10UL)
+#elif CAN_BT_OK(9UL)
+#define CAN_BT_TQ                  (9UL)
+#elif CAN_BT_OK(8UL)
+#define CAN_BT_TQ                  (8UL)
+#else
+#error "No exact CAN bit timing for BSP_TARGET_CAN_PCLK_HZ and the baud rate"
+#endif
+#define CAN_BTR_VALUE              (((CAN_BT_SJW - 1UL) << 24) | ((CAN_BT_TS2(CAN_BT_TQ) - 1UL) << 20) | \
+                                    ((CAN_BT_TS1(CAN_BT_TQ) - 1UL) << 16) | (CAN_BT_PRESCALER(CAN_BT_TQ) - 1UL))
 /* ********************* Type definitions ( typedef ) *************************/
 /* ***************** Global data declarations ( extern ) **********************/
 /* ***** External parameter / constant declarations ( extern const ) **********/
@@ -30,10 +113,20 @@ typedef union {
     uint8_t     Byte[8];
 }tCANData;
 
-void CanInit(tBSPType BSPType);
+typedef struct {
+    tCANData    Data;
+    uint32_t    Id;         // Identifier as written to TIR
+    uint32_t    Length;     // DLC
+}tCANFrame;
+
+eFUNCTION_RETURN CanInit(tBSPType BSPType);
 void CanSend(uint8_t *pTxData, uint16_t size);
+void CanSendFrame(const tCANData *pTxData, const uint32_t length);
+eFUNCTION_RETURN CanRecvFrame(tCANData *pRxData, uint32_t *pLength);
 void CanReset(void);
 eFUNCTION_RETURN CanRecv(uint8_t *pRxData, uint16_t size);
+eFUNCTION_RETURN CanRecvBlock(uint8_t *pRxData, uint16_t size);
+void CEC_CAN_IRQHandler(void);
 
 #endif // CAN_H_
 
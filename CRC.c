@@ -12,15 +12,32 @@
 
 /* *************** Constant / macro definitions ( #define ) *******************/
 #define CRC16 0xAA55
+/** Final XOR of CRC-32 as in zlib, the polynomial 0x04C11DB7 is fixed in the CRC unit */
+#define CRC32_XOR_OUT           (0xFFFFFFFFUL)
+/** One step of the augmented CRC: shift the register by one bit, the bit shifted out selects the polynomial */
+#define CRC16_STEP(x)           ((((x) << 1) & 0xFFFFU) ^ ((((x) & 0x8000U) != 0U) ? CRC16 : 0U))
+/** The polynomials of four steps only depend on the top nibble of the register, the data bits
+ *  shifted in at the bottom do not reach bit 15 before */
+#define CRC16_NIBBLE(t)         CRC16_STEP(CRC16_STEP(CRC16_STEP(CRC16_STEP((uint16_t)(t) << 12))))
 /* ********************* Type definitions ( typedef ) *************************/
 /* *********************** Global data definitions ****************************/
 /* **************** Global constant definitions ( const ) *********************/
 /* ***************** Modul global data segment ( static ) *********************/
+/* *************** Modul global constants ( static const ) ********************/
+static const uint16_t CRC16Table[16] =
+{
+    CRC16_NIBBLE(0x0U), CRC16_NIBBLE(0x1U), CRC16_NIBBLE(0x2U), CRC16_NIBBLE(0x3U),
+    CRC16_NIBBLE(0x4U), CRC16_NIBBLE(0x5U), CRC16_NIBBLE(0x6U), CRC16_NIBBLE(0x7U),
+    CRC16_NIBBLE(0x8U), CRC16_NIBBLE(0x9U), CRC16_NIBBLE(0xAU), CRC16_NIBBLE(0xBU),
+    CRC16_NIBBLE(0xCU), CRC16_NIBBLE(0xDU), CRC16_NIBBLE(0xEU), CRC16_NIBBLE(0xFU)
+};
 /* **************** Local func/proc prototypes ( static ) *********************/
 /******************************************************************************/
 /**
 * uint16_t CRCCalc16(const uint8_t *data, uint16_t size, uint16_t startVal)
-* @brief Generate 16 bits CRC for an input array.
+* @brief Generate 16 bits CRC for an input array. The bits are shifted in MSB
+*        first without augmentation, four at a time with a table of the
+*        polynomials selected by the top nibble of the register.
 *
 * @param[in] data pointer to data array
 * @param[in] size byte number of the array
@@ -30,7 +47,6 @@
 uint16_t CRCCalc16(const uint8_t *data, uint16_t size, uint16_t startVal)
 {
     uint16_t out = startVal;
-    uint8_t bits_read = 0, bit_flag;
     /* Sanity check */
     if(data == NULL)
     {
@@ -38,23 +54,45 @@ uint16_t CRCCalc16(const uint8_t *data, uint16_t size, uint16_t startVal)
     }
     while(size > 0)
     {
-        bit_flag = out >> 15;
-        /* Get next bit */
-        out <<= 1;
-        out |= (*data >> (7 - bits_read)) & 1;
-        /* Increment bit counter */
-        bits_read++;
-        if(bits_read > 7)
-        {
-            bits_read = 0;
-            data++;
-            size--;
-        }
-        /* Cycle check */
-        if(bit_flag)
-        {
-            out ^= CRC16;
-        }
+        /* High nibble, then low nibble of the next byte */
+        out = (uint16_t)((out << 4) | (*data >> 4)) ^ CRC16Table[out >> 12];
+        out = (uint16_t)((out << 4) | (*data & 0x0FU)) ^ CRC16Table[out >> 12];
+        data++;
+        size--;
     }
     return out;
 }
+
+/******************************************************************************/
+/**
+* uint32_t CRCCalc32(const uint32_t *data, uint32_t words, uint32_t startVal)
+* @brief Generate CRC-32 (as zlib crc32) for an array of words with the CRC
+*        unit. The bits of each word are reversed on the way in, so the bytes
+*        are taken in memory order LSB first, and the result is reversed.
+*
+* @param[in] data pointer to word aligned data array, may be in flash
+* @param[in] words number of words of the array
+* @param[in] startVal CRC of the preceding data to continue with, 0 to start
+* @returns   calculated 32 bits CRC.
+*******************************************************************************/
+uint32_t CRCCalc32(const uint32_t *data, uint32_t words, uint32_t startVal)
+{
+    uint32_t init = 0UL;
+
+    /** The CRC unit starts from the register value, which is the reversed CRC before the final XOR */
+    startVal ^= CRC32_XOR_OUT;
+    for(uint8_t i = 0U; i < 32U; i++)
+    {
+        init = (init << 1) | (startVal & 1UL);
+        startVal >>= 1;
+    }
+    RCC->AHBENR |= RCC_AHBENR_CRCEN;
+    CRC->INIT = init;
+    CRC->CR = CRC_CR_REV_IN | CRC_CR_REV_OUT | CRC_CR_RESET;
+    while(words > 0U)
+    {
+        CRC->DR = *data++;
+        words--;
+    }
+    return CRC->DR ^ CRC32_XOR_OUT;
+}
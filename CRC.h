@@ -10,12 +10,15 @@
 
 #include <stdint.h>
 
+#include <stm32f0xx.h>
+
 /* *************** Constant / macro definitions ( #define ) *******************/
 /* ********************* Type definitions ( typedef ) *************************/
 /* ***************** Global data declarations ( extern ) **********************/
 /* ***** External parameter / constant declarations ( extern const ) **********/
 /* ********************** Global func/proc prototypes *************************/
 uint16_t CRCCalc16(const uint8_t *data, uint16_t size, uint16_t startVal);
+uint32_t CRCCalc32(const uint32_t *data, uint32_t words, uint32_t startVal);
 
 #endif
 
@@ -21,6 +21,19 @@ typedef enum
     eCMD_BootloadMode   = 0xFC03, /**< Needs to come within 1s after start up to stay in bootloader mode     */
     eCMD_WriteCRC       = 0xFB04, /**< Finish writting application, write 2 bytes CRC and 2 bytes length     */
     eCMD_Finish         = 0xFA05, /**< End of bootloader mode; jump to application code                      */
+    eCMD_WriteWindow    = 0xF906, /**< Like eCMD_WriteMemory, but several packets may be in flight           */
+    eCMD_SetBlockSize   = 0xF807, /**< Followed by 2 bytes block size, power of two from 64 to a flash page  */
+    eCMD_WriteCompressed= 0xF708, /**< Like eCMD_WriteWindow, but packets carry an LZSS compressed image     */
+    eCMD_KeepFlash      = 0xF609, /**< Instead of eCMD_EraseFlash, keep current firmware for a delta update  */
+    eCMD_WriteDelta     = 0xF50A, /**< Like eCMD_WriteWindow, but packets carry a patch against the firmware */
+    eCMD_PageDigest     = 0xF40B, /**< Followed by tDIGEST_LIST, following erase only affects changed pages  */
+    eCMD_Resume         = 0xF30C, /**< Instead of eCMD_EraseFlash, reply holds the sequence count to resume */
+    eCMD_EraseImage     = 0xF20D, /**< Followed by 2 bytes image length, erase only the pages of the image   */
+    eCMD_WriteChecked   = 0xF10E, /**< Like eCMD_WriteMemory, but the packet CRC is checked by the interface */
+    eCMD_WriteMulticast = 0xF00F, /**< Blocks from a stream to a group in any order, see eCMD_MissingBlocks */
+    eCMD_MissingBlocks  = 0xEF10, /**< Followed by tBLOCK_RANGE, reply tMISSING_BLOCKS in this range      */
+    eCMD_VerifyPolicy   = 0xEE11, /**< Followed by 2 bytes eFlashVerify_t, when written data is read back  */
+    eCMD_Status         = 0xED12, /**< Reply tSESSION_STATUS                                              */
     eCMD_NotValid       = 0x0000  /**< */
 }eCOMMAND_ID;
 
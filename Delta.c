@@ -0,0 +1,237 @@
+/******************************************************************************/
+/**
+* @file Delta.c
+* @brief Apply a binary patch against the firmware which is already in flash
+*
+*******************************************************************************/
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "Delta.h"
+
+#if defined(SELECT_DELTA)
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+/** Number of parameter bytes following the operation code */
+#define DELTA_COPY_PARAM_SIZE   (4U)
+#define DELTA_DATA_PARAM_SIZE   (2U)
+/* ********************* Type definitions ( typedef ) *************************/
+/** State of the patch engine at the start of a packet */
+typedef struct {
+    uint16_t PageNo;
+    uint16_t Fill;
+    uint8_t  Op;
+    uint8_t  Param[DELTA_COPY_PARAM_SIZE];
+    uint8_t  ParamFill;
+    uint16_t Remaining;
+}tDeltaState;
+/* *********************** Global data definitions ****************************/
+/* **************** Global constant definitions ( const ) *********************/
+/* ***************** Modul global data segment ( static ) *********************/
+static uint8_t  Page[BSP_FLASH_PAGE_SIZE_BYTES];
+static uint16_t PageNo = 0U;
+static uint16_t Fill = 0U;
+static uint8_t  Op = 0U;
+static uint8_t  Param[DELTA_COPY_PARAM_SIZE];
+static uint8_t  ParamFill = 0U;
+static uint16_t Remaining = 0U;
+static uint8_t  Done = 0U;
+static eFlashError_t Failed = eFlash_OK;   /**< Error which ended the session */
+static tDeltaState Saved;
+/* *************** Modul global constants ( static const ) ********************/
+/* **************** Local func/proc prototypes ( static ) *********************/
+static eFlashError_t DeltaPut(uint8_t data);
+static eFlashError_t DeltaCopy(uint16_t offset, uint16_t length);
+/******************************************************************************/
+/**
+* void DeltaInit(void)
+* @brief Reset the patch engine, the new image starts at the start of application.
+*
+*******************************************************************************/
+void DeltaInit(void)
+{
+    PageNo = 0U;
+    Fill = 0U;
+    Op = 0U;
+    ParamFill = 0U;
+    Remaining = 0U;
+    Done = 0U;
+    Failed = eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t DeltaApply(const uint8_t *pData, uint16_t size)
+* @brief Apply the next part of the patch. Operations may be split between
+*        two calls. If the part fails before flash is changed, the patch engine
+*        returns to the state before it, so the packet can be sent again. Once
+*        a page was replaced or a page update failed, the installed image the
+*        patch refers to is gone and the session ends with the error.
+*
+* @param[in] pData pointer to patch data
+* @param[in] size number of patch bytes
+* @returns   eFlash_OK if all bytes are processed
+*            or
+*            eFlash_LastAddress if the last page of program flash is updated
+*            or
+*            error of flash update or a corrupted patch otherwise.
+*
+*******************************************************************************/
+eFlashError_t DeltaApply(const uint8_t *pData, uint16_t size)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+
+    if(pData == NULL)
+    {
+        return eFlash_AddressError;
+    }
+    /** Padding behind the end of the image is ignored */
+    if(Done != 0U)
+    {
+        return eFlash_LastAddress;
+    }
+    if(eFlash_OK != Failed)
+    {
+        return Failed;
+    }
+    Saved.PageNo = PageNo;
+    Saved.Fill = Fill;
+    Saved.Op = Op;
+    memcpy(Saved.Param, Param, sizeof(Param));
+    Saved.ParamFill = ParamFill;
+    Saved.Remaining = Remaining;
+    while((size > 0U) && (eFlash_OK == eFlashError))
+    {
+        if(Op == 0U)
+        {
+            Op = *pData;
+            ParamFill = 0U;
+            if((Op != DELTA_OP_COPY) && (Op != DELTA_OP_DATA))
+            {
+                Op = 0U;
+                eFlashError = eFlash_AddressError;
+            }
+        }
+        else if(Op == DELTA_OP_COPY)
+        {
+            Param[ParamFill++] = *pData;
+            if(ParamFill >= DELTA_COPY_PARAM_SIZE)
+            {
+                Op = 0U;
+                eFlashError = DeltaCopy((uint16_t)(Param[1] << 8) | Param[0],
+                                        (uint16_t)(Param[3] << 8) | Param[2]);
+            }
+        }
+        else if(ParamFill < DELTA_DATA_PARAM_SIZE)
+        {
+            Param[ParamFill++] = *pData;
+            if(ParamFill >= DELTA_DATA_PARAM_SIZE)
+            {
+                Remaining = (uint16_t)(Param[1] << 8) | Param[0];
+                if(Remaining == 0U)
+                {
+                    Op = 0U;
+                }
+            }
+        }
+        else
+        {
+            eFlashError = DeltaPut(*pData);
+            Remaining--;
+            if(Remaining == 0U)
+            {
+                Op = 0U;
+            }
+        }
+        pData++;
+        size--;
+    }
+    if(eFlash_LastAddress == eFlashError)
+    {
+        Done = 1U;
+    }
+    else if(eFlash_OK != eFlashError)
+    {
+        if((PageNo != Saved.PageNo) || (eFlash_OK != Failed))
+        {
+            Failed = eFlashError;
+        }else
+        {
+            /** The page which is built still holds the bytes before the packet */
+            Fill = Saved.Fill;
+            Op = Saved.Op;
+            memcpy(Param, Saved.Param, sizeof(Param));
+            ParamFill = Saved.ParamFill;
+            Remaining = Saved.Remaining;
+        }
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t DeltaPut(uint8_t data)
+* @brief Append one byte to the page which is built, update the page in flash
+*        when it is complete. The next page is only started if the update was
+*        successful.
+*
+* @param[in] data byte of the new image
+* @returns   result of the page update or eFlash_OK
+*
+*******************************************************************************/
+static eFlashError_t DeltaPut(uint8_t data)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+
+    Page[Fill++] = data;
+    if(Fill >= BSP_FLASH_PAGE_SIZE_BYTES)
+    {
+        eFlashError = FlashUpdatePage(Page, PageNo);
+        if((eFlash_OK == eFlashError) || (eFlash_LastAddress == eFlashError))
+        {
+            PageNo++;
+            Fill = 0U;
+        }else
+        {
+            /** The page may be erased already */
+            Failed = eFlashError;
+        }
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t DeltaCopy(uint16_t offset, uint16_t length)
+* @brief Copy bytes of the installed image into the new image. Pages before
+*        the page which is built are already replaced and can't be referenced.
+*
+* @param[in] offset offset of the first byte in the installed image
+* @param[in] length number of bytes to be copied
+* @returns   eFlash_AddressError if the source is already replaced or outside
+*            of the application area
+*            or
+*            result of DeltaPut() otherwise.
+*
+*******************************************************************************/
+static eFlashError_t DeltaCopy(uint16_t offset, uint16_t length)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+
+    while((length > 0U) && (eFlash_OK == eFlashError))
+    {
+        if((offset < ((uint32_t)PageNo * BSP_FLASH_PAGE_SIZE_BYTES)) ||
+           (offset >= ((uint32_t)FlashAppPages() * BSP_FLASH_PAGE_SIZE_BYTES)))
+        {
+            return eFlash_AddressError;
+        }
+        eFlashError = DeltaPut(*(const uint8_t *)(BSP_ABSOLUTE_APP_START + offset));
+        offset++;
+        length--;
+    }
+    return eFlashError;
+}
+
+#endif // SELECT_DELTA
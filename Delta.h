@@ -0,0 +1,42 @@
+/******************************************************************************/
+/**
+* @file Delta.h
+* @brief Apply a binary patch against the firmware which is already in flash
+*
+* The patch describes the new image from the start of application to the end
+* of the application area as a sequence of operations:
+* - DELTA_OP_COPY, two-byte offset, two-byte length: copy length bytes of the
+*   installed image starting at offset.
+* - DELTA_OP_DATA, two-byte length, length bytes: insert the bytes.
+* All values are little endian and offsets are counted from the start of
+* application. The new image is built page by page in RAM and each page is
+* erased and programmed only if it differs from flash. To stay in-place safe,
+* a copy must not reference a page before the page which is currently built.
+*
+*******************************************************************************/
+#if defined(SELECT_DELTA)
+
+#ifndef DELTA_H
+#define DELTA_H
+
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+
+#include "Flash.h"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+#define DELTA_OP_COPY           (0x01U)
+#define DELTA_OP_DATA           (0x02U)
+/* ********************* Type definitions ( typedef ) *************************/
+/* ***************** Global data declarations ( extern ) **********************/
+/* ***** External parameter / constant declarations ( extern const ) **********/
+/* ********************** Global func/proc prototypes *************************/
+void DeltaInit(void);
+eFlashError_t DeltaApply(const uint8_t *pData, uint16_t size);
+
+#endif
+
+#endif // SELECT_DELTA
+
+/* end of Delta.h */
@@ -7,6 +7,7 @@
 /* ***************** Header / include files ( #include ) **********************/
 
 #include <stddef.h>
+#include <string.h>
 
 #include <stm32f0xx.h>
 
@@ -20,6 +21,31 @@
 /* **************** Global constant definitions ( const ) *********************/
 /* ***************** Modul global data segment ( static ) *********************/
 static tFlashLimits FlashSettings;
+static uint32_t     EraseMask = 0UL;        /**< Pages which are still to be erased  */
+static uint32_t     EraseActive = 0UL;      /**< Page which is erased at the moment   */
+static eFlashError_t EraseError = eFlash_OK;
+static uint32_t     ImageNext = 0UL;        /**< Next address of the image in sequence, 0 if not accumulated */
+static uint16_t     ImageLength = 0U;       /**< Length of the image announced by FlashEraseImage */
+static uint16_t     ImageCRC16 = 0U;        /**< CRCCalc16 over the image written so far */
+static uint32_t     ImageCRC32 = 0UL;       /**< CRCCalc32 over the image written so far */
+static uint32_t     VerifyCycles = 0UL;     /**< Core clock cycles of the last FlashVerifyFirmware */
+static eFlashVerify_t VerifyPolicy = eVerify_Block;
+static uint32_t     PageNext = 0UL;         /**< Next address in sequence in the page, eVerify_Page */
+static uint16_t     PageCRC = 0U;           /**< CRCCalc16 over the data written to the page so far */
+static uint8_t      ImageUnverified = 0U;   /**< Data was written without being read back */
+static uint32_t     JournalNext = 0UL;      /**< End of the data written in sequence, 0 if no journal is kept */
+static uint16_t     JournalPages = 0U;      /**< Pages marked as complete in the journal */
+/* **************** Local func/proc prototypes ( static ) *********************/
+static BSP_RAMFUNC eFlashError_t FlashProgram(uint16_t *p16, const uint8_t *buf, const uint16_t size, const uint8_t verify);
+static BSP_RAMFUNC eFlashError_t FlashProgramHalfWord(uint16_t *p16, const uint16_t data);
+static BSP_RAMFUNC eFlashError_t FlashEraseNext(const uint32_t pages);
+static BSP_RAMFUNC eFlashError_t FlashEraseWait(const uint32_t endAddress);
+static eFlashError_t FlashEraseSetup(const uint32_t pageMask);
+static eFlashError_t FlashJournalOpen(void);
+static eFlashError_t FlashJournalClose(void);
+static eFlashError_t FlashJournalAdvance(const uint32_t address, const uint32_t size);
+static eFlashError_t FlashVerifyImage(void);
+static void FlashImageAccumulate(const uint32_t address, const uint8_t *pData, const uint32_t size);
 /******************************************************************************/
 /**
 * void FlashInit(void)
@@ -32,21 +58,40 @@ void FlashInit(tBSPType BSPType)
 {
     if(BSPType == BSP_Pilot)
     {
+        FlashSettings.JOURNALinFlash = BSP_ABSOLUTE_FLASH_END_16KB - 8UL - FLASH_JOURNAL_BYTES;
+        FlashSettings.CRC32inFlash = BSP_ABSOLUTE_FLASH_END_16KB - 8UL;
         FlashSettings.CRCinFlash = BSP_ABSOLUTE_FLASH_END_16KB - 4UL;
         FlashSettings.LENinFlash = BSP_ABSOLUTE_FLASH_END_16KB - 2UL;
         FlashSettings.TOTALPages = BSP_APP_PROGRAM_PAGES_16KB;
     }else 
     {
+        FlashSettings.JOURNALinFlash = BSP_ABSOLUTE_FLASH_END_32KB - 8UL - FLASH_JOURNAL_BYTES;
+        FlashSettings.CRC32inFlash = BSP_ABSOLUTE_FLASH_END_32KB - 8UL;
         FlashSettings.CRCinFlash = BSP_ABSOLUTE_FLASH_END_32KB - 4UL;
         FlashSettings.LENinFlash = BSP_ABSOLUTE_FLASH_END_32KB - 2UL;
         FlashSettings.TOTALPages = BSP_APP_PROGRAM_PAGES_32KB;
     }
 }
 
+/******************************************************************************/
+/**
+* uint16_t FlashAppPages(void)
+* @brief Number of flash pages in the application area of the target board.
+*
+* @returns   number of pages
+*
+*******************************************************************************/
+uint16_t FlashAppPages(void)
+{
+    return (uint16_t)FlashSettings.TOTALPages;
+}
+
 /******************************************************************************/
 /**
 * eFlashError_t FlashWrite(uint8_t* buf, uint16_t size)
-* @brief Write to Flash and lock it afterwards.
+* @brief Write to Flash and lock it afterwards. The data is verified as
+*        selected by FlashVerifyPolicy. The journal in the last page is left
+*        as it is, the block has to hold 0xFF there.
 *
 * @param[in] buf pointer to data to be written to flash
 * @param[in] size number of bytes
@@ -56,55 +101,246 @@ void FlashInit(tBSPType BSPType)
 *******************************************************************************/
 eFlashError_t FlashWrite(uint8_t* buf, const uint16_t size, const uint16_t pktNo)
 {
-    uint16_t i = 0;
-    uint32_t flashWait = BootTIMEOUT;
+    eFlashError_t eFlashError;
+    uint8_t verify;
     uint16_t* p16 = (uint16_t *)(BSP_ABSOLUTE_APP_START + (pktNo * size));  
+    uint16_t bytes = size;                  /**< Bytes before the journal      */
+    uint16_t tail = size;                   /**< First byte after the journal  */
     /**
-     *    Size should be a non zero number less than 1025 and should be a multiple
-     *     of two since we write 2 bytes.
+     *    Size should be a non zero number not larger than a flash page and should
+     *     be a multiple of two since we write 2 bytes.
      */
-    if((size > 1024UL) || (size == 0) || (buf == NULL))
+    if((size > BSP_FLASH_PAGE_SIZE_BYTES) || (size == 0) || (buf == NULL))
+    {
+        return eFlash_AddressError;
+    }
+    /** The block has to be inside the application area of the target */
+    if(((uint32_t)p16 + size) > (BSP_ABSOLUTE_APP_START + (FlashSettings.TOTALPages * BSP_FLASH_PAGE_SIZE_BYTES)))
     {
         return eFlash_AddressError;
     }
+    /** The journal is not programmed, the block has to be erased there */
+    if(((uint32_t)p16 + size) > FlashSettings.JOURNALinFlash)
+    {
+        bytes = ((uint32_t)p16 < FlashSettings.JOURNALinFlash) ? (uint16_t)(FlashSettings.JOURNALinFlash - (uint32_t)p16) : 0U;
+        if(((uint32_t)p16 + size) > FlashSettings.CRC32inFlash)
+        {
+            tail = ((uint32_t)p16 < FlashSettings.CRC32inFlash) ? (uint16_t)(FlashSettings.CRC32inFlash - (uint32_t)p16) : 0U;
+        }
+        for(uint16_t i = bytes; i < tail; i++)
+        {
+            if(buf[i] != 0xFFU)
+            {
+                return eFlash_AddressError;
+            }
+        }
+    }
+    eFlashError = FlashEraseWait((uint32_t)p16 + size);
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
     
-    // Program Flash Page
-    FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
-    while(i < size) 
+    /** Blocks of a page in sequence are checked together when the page is complete,
+     *  a block out of sequence is read back right away */
+    verify = 1U;
+    if(VerifyPolicy == eVerify_Page)
     {
-        FLASH->CR |= FLASH_CR_PG;
-        *p16++ = (uint16_t)(buf[i+1] << 8) | buf[i];
-        /* Reload the busy wait timeout */
-        flashWait = BootTIMEOUT;  
-        while((FLASH->SR & FLASH_SR_BSY) != 0)
+        if(((uint32_t)p16 % BSP_FLASH_PAGE_SIZE_BYTES) == 0UL)
         {
-            if(!(flashWait--))
+            if(PageNext != 0UL)
             {
-                /** Return if the busy wait timer expires */
-                return eFlash_WriteTimeOut;
+                /** The page before was not completed in sequence */
+                ImageUnverified = 1U;
             }
+            PageNext = (uint32_t)p16;
+            PageCRC = 0U;
         }
-        FLASH->CR &= ~FLASH_CR_PG;
-        if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0)
+        if((uint32_t)p16 == PageNext)
         {
-            FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
-            return eFlash_WriteError;
+            verify = 0U;
+        }else if((PageNext != 0UL) && ((uint32_t)p16 > PageNext))
+        {
+            /** The blocks of the page before the gap are left to the image check */
+            ImageUnverified = 1U;
+            PageNext = 0UL;
         }
-        i += sizeof(uint16_t);
+    }else if(VerifyPolicy == eVerify_Image)
+    {
+        verify = 0U;
+        ImageUnverified = 1U;
     }
-    /** Lets verify flash if we have written correctly */
-    i = 0;
-    p16 = (uint16_t *)(BSP_ABSOLUTE_APP_START + (pktNo * size));
-    while(i < size) 
+    /** Flash differs from the block at the journal, the block is read back right away */
+    if(bytes != size)
     {
-        if(*p16++ != ((uint16_t)(buf[i+1] << 8) | buf[i]))
+        verify = 1U;
+        if((PageNext != 0UL) && (PageNext != (uint32_t)p16))
+        {
+            ImageUnverified = 1U;
+        }
+        PageNext = 0UL;
+    }
+    // Program Flash Page and verify it
+    eFlashError = FlashProgram(p16, buf, bytes, verify);
+    if((eFlash_OK == eFlashError) && (tail < size))
+    {
+        eFlashError = FlashProgram(p16 + (tail / sizeof(uint16_t)), buf + tail, size - tail, verify);
+    }
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
+    if((VerifyPolicy == eVerify_Page) && ((uint32_t)p16 == PageNext))
+    {
+        PageCRC = CRCCalc16(buf, size, PageCRC);
+        PageNext += size;
+        if((PageNext % BSP_FLASH_PAGE_SIZE_BYTES) == 0UL)
+        {
+            PageNext -= BSP_FLASH_PAGE_SIZE_BYTES;
+            eFlashError = (CRCCalc16((const uint8_t *)PageNext, BSP_FLASH_PAGE_SIZE_BYTES, 0U) == PageCRC) ? eFlash_OK : eFlash_ReadError;
+            PageNext = 0UL;
+            if(eFlash_OK != eFlashError)
+            {
+                /** The image CRC must not be trusted if the page is written again */
+                ImageUnverified = 1U;
+                return eFlashError;
+            }
+        }
+    }
+    eFlashError = FlashJournalAdvance((uint32_t)p16, bytes);
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
+    FlashImageAccumulate((uint32_t)p16, buf, size);
+    /** Check if the pointer is pointing at the last address of Program Flash */
+    if((p16 + (size / sizeof(uint16_t))) == (uint16_t*)(FlashSettings.LENinFlash + sizeof(uint16_t)))
+    {
+        return eFlash_LastAddress;
+    }
+    return eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashFill(const uint16_t blockNo, const uint16_t count, const uint16_t size, const uint16_t pattern)
+* @brief Fill consecutive blocks of erased flash with a constant halfword.
+*        Filling with 0xFFFF only checks the range since erased flash already
+*        holds the pattern.
+*
+* @param[in] blockNo number of the first block
+* @param[in] count number of blocks
+* @param[in] size number of bytes of each block
+* @param[in] pattern halfword to be written
+* @returns   eFlash_OK if successful
+*            or
+*            eFlash_LastAddress if the range ends at the last address of Program Flash
+*            or
+*            error otherwise.
+*
+*******************************************************************************/
+eFlashError_t FlashFill(const uint16_t blockNo, const uint16_t count, const uint16_t size, const uint16_t pattern)
+{
+    eFlashError_t eFlashError;
+    uint16_t* p16 = (uint16_t *)(BSP_ABSOLUTE_APP_START + ((uint32_t)blockNo * size));
+    uint16_t* pEnd = (uint16_t *)(BSP_ABSOLUTE_APP_START + (((uint32_t)blockNo + count) * size));
+    uint16_t* pFill = pEnd;
+    uint32_t start;
+
+    if((size == 0) || (count == 0) || (pEnd > (uint16_t*)(FlashSettings.LENinFlash + sizeof(uint16_t))))
+    {
+        return eFlash_AddressError;
+    }
+    /** The journal is not programmed, erased flash after it already holds the pattern */
+    if((pEnd > (uint16_t*)FlashSettings.JOURNALinFlash) && (p16 < (uint16_t*)FlashSettings.CRC32inFlash))
+    {
+        if(pattern != 0xFFFFU)
+        {
+            return eFlash_AddressError;
+        }
+        pFill = (p16 < (uint16_t*)FlashSettings.JOURNALinFlash) ? (uint16_t*)FlashSettings.JOURNALinFlash : p16;
+    }
+    eFlashError = FlashEraseWait((uint32_t)pEnd);
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
+    FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    while(p16 < pFill)
+    {
+        eFlashError = FlashProgramHalfWord(p16, pattern);
+        if(eFlash_OK != eFlashError)
+        {
+            return eFlashError;
+        }
+        if(*p16++ != pattern)
         {
             return eFlash_ReadError;
         }
-        i += sizeof(uint16_t);
     }
+    start = BSP_ABSOLUTE_APP_START + ((uint32_t)blockNo * size);
+    eFlashError = FlashJournalAdvance(start, (uint32_t)pFill - start);
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
+    FlashImageAccumulate(start, (const uint8_t *)start, (uint32_t)count * size);
     /** Check if the pointer is pointing at the last address of Program Flash */
-    if(p16 == (uint16_t*)(FlashSettings.LENinFlash + sizeof(uint16_t)))
+    if(pEnd == (uint16_t*)(FlashSettings.LENinFlash + sizeof(uint16_t)))
+    {
+        return eFlash_LastAddress;
+    }
+    return eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashKeep(const uint16_t blockNo, const uint16_t count, const uint16_t size)
+* @brief Keep consecutive blocks as they are in flash, only the range is checked.
+*        The range must not be on a page which is erased in the background.
+*
+* @param[in] blockNo number of the first block
+* @param[in] count number of blocks
+* @param[in] size number of bytes of each block
+* @returns   eFlash_OK if the range is inside of the application area
+*            or
+*            eFlash_LastAddress if the range ends at the last address of Program Flash
+*            or
+*            eFlash_AddressError otherwise.
+*
+*******************************************************************************/
+eFlashError_t FlashKeep(const uint16_t blockNo, const uint16_t count, const uint16_t size)
+{
+    uint32_t end = BSP_ABSOLUTE_APP_START + (((uint32_t)blockNo + count) * size);
+    uint32_t start;
+    uint32_t pages;
+    eFlashError_t eFlashError;
+
+    if((size == 0) || (count == 0) || (end > (FlashSettings.LENinFlash + sizeof(uint16_t))))
+    {
+        return eFlash_AddressError;
+    }
+    start = BSP_ABSOLUTE_APP_START + ((uint32_t)blockNo * size);
+    /** A page which is erased or still to be erased can not be kept */
+    pages = (2UL << ((end - 1UL - BSP_ABSOLUTE_APP_START) / BSP_FLASH_PAGE_SIZE_BYTES)) - 1UL;
+    pages &= ~((1UL << ((start - BSP_ABSOLUTE_APP_START) / BSP_FLASH_PAGE_SIZE_BYTES)) - 1UL);
+    if(((EraseMask | EraseActive) & pages) != 0UL)
+    {
+        return eFlash_AddressError;
+    }
+    /** The journal is programmed and the kept range is read, so no erase may run */
+    eFlashError = FlashEraseWait(end);
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
+    /** Kept pages hold their final content like written ones */
+    if(FlashJournalAdvance(start, ((end > FlashSettings.JOURNALinFlash) ? FlashSettings.JOURNALinFlash : end) - start) != eFlash_OK)
+    {
+        return eFlash_WriteError;
+    }
+    FlashImageAccumulate(start, (const uint8_t *)start, end - start);
+    if(end == (FlashSettings.LENinFlash + sizeof(uint16_t)))
     {
         return eFlash_LastAddress;
     }
@@ -113,18 +349,165 @@ eFlashError_t FlashWrite(uint8_t* buf, const uint16_t size, const uint16_t pktNo
 
 /******************************************************************************/
 /**
-* eFlashError_t FlashErase(void)
-* @brief Erase Flash from start of application to the last page, each page is 1kB.
+* uint16_t FlashPageDigest(const uint16_t pageNo)
+* @brief Calculate the CRC over one page of the application area. The journal
+*        in the last page is taken as erased, as the image holds it.
+*
+* @param[in] pageNo page number counted from the start of application
+* @returns   CRC of the page
+*
+*******************************************************************************/
+uint16_t FlashPageDigest(const uint16_t pageNo)
+{
+    const uint8_t erased = 0xFFU;
+    uint32_t start = BSP_ABSOLUTE_APP_START + ((uint32_t)pageNo * BSP_FLASH_PAGE_SIZE_BYTES);
+    uint16_t crc;
+
+    if((start + BSP_FLASH_PAGE_SIZE_BYTES) <= FlashSettings.JOURNALinFlash)
+    {
+        return CRCCalc16((const uint8_t *)start, BSP_FLASH_PAGE_SIZE_BYTES, 0);
+    }
+    crc = CRCCalc16((const uint8_t *)start, (uint16_t)(FlashSettings.JOURNALinFlash - start), 0);
+    for(uint32_t i = 0UL; i < FLASH_JOURNAL_BYTES; i++)
+    {
+        crc = CRCCalc16(&erased, 1U, crc);
+    }
+    return CRCCalc16((const uint8_t *)FlashSettings.CRC32inFlash,
+                     (uint16_t)(start + BSP_FLASH_PAGE_SIZE_BYTES - FlashSettings.CRC32inFlash), crc);
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashEraseStart(const uint32_t pageMask)
+* @brief Unlock flash and start erasing pages of the application area in the
+*        background. The pages are erased in ascending order by FlashEraseRun(),
+*        writes to a page wait until it is erased, so data for one page is
+*        accepted while the next pages are still erased. If the last page is
+*        erased, it is erased right away and holds the journal of the update,
+*        see FlashResume.
+*
+* @param[in] pageMask bit n is set if page n of the application area is erased,
+*            FLASH_ALL_PAGES for all pages
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+eFlashError_t FlashEraseStart(const uint32_t pageMask)
+{
+    const uint32_t lastPage = 1UL << (FlashSettings.TOTALPages - 1UL);
+    eFlashError_t eFlashError = FlashEraseSetup(pageMask & ~lastPage);
+
+    /** An update of the last page keeps a journal there for FlashResume, the page is erased first */
+    if(eFlash_OK == eFlashError)
+    {
+        eFlashError = ((pageMask & lastPage) != 0UL) ? FlashJournalOpen() : FlashJournalClose();
+    }
+    if(eFlash_OK != eFlashError)
+    {
+        EraseMask = 0UL;
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashEraseSetup(const uint32_t pageMask)
+* @brief Unlock flash, complete an erase in progress and select the pages which
+*        are erased in the background.
+*
+* @param[in] pageMask bit n is set if page n of the application area is erased
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+static eFlashError_t FlashEraseSetup(const uint32_t pageMask)
+{
+    eFlashError_t eFlashError = FlashUnlock();
+
+    /** An erase started by an earlier command is completed first */
+    EraseMask = 0UL;
+    EraseError = eFlash_OK;
+    if(eFlash_OK == eFlashError)
+    {
+        eFlashError = FlashEraseWait(BSP_ABSOLUTE_APP_START);
+    }
+    EraseActive = 0UL;
+    EraseError = eFlashError;
+    /** The image CRC is only accumulated if the length of the image is known */
+    ImageNext = 0UL;
+    ImageUnverified = 0U;
+    PageNext = 0UL;
+    if(eFlash_OK == eFlashError)
+    {
+        EraseMask = pageMask & ((1UL << FlashSettings.TOTALPages) - 1UL);
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashEraseImage(const uint16_t length)
+* @brief Start erasing only the pages covered by an image of the given length
+*        and the last page, which holds the firmware parameters. The CRC of
+*        the image is accumulated while it is written.
 *
+* @param[in] length number of bytes of the image
 * @returns   eFlash_OK if successful
+*            or
+*            eFlash_AddressError if the image does not fit into the application area.
 *
 *******************************************************************************/
-eFlashError_t FlashErase(void)
+eFlashError_t FlashEraseImage(const uint16_t length)
+{
+    uint32_t pages = ((uint32_t)length + BSP_FLASH_PAGE_SIZE_BYTES - 1UL) / BSP_FLASH_PAGE_SIZE_BYTES;
+
+    eFlashError_t eFlashError;
+
+    if((length == 0U) || (length > (FlashSettings.JOURNALinFlash - BSP_ABSOLUTE_APP_START)))
+    {
+        return eFlash_AddressError;
+    }
+    eFlashError = FlashEraseStart(((1UL << pages) - 1UL) | (1UL << (FlashSettings.TOTALPages - 1UL)));
+    /** Blocks written in sequence are added to the image CRC, see FlashVerifyFirmware */
+    ImageNext = BSP_ABSOLUTE_APP_START;
+    ImageLength = length;
+    ImageCRC16 = 0U;
+    ImageCRC32 = 0UL;
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashEraseRun(void)
+* @brief Erase engine, never waits for flash. Completes the page erase which is
+*        in progress and starts the erase of the next pending page. Has to be
+*        called periodically after FlashEraseStart().
+*
+* @returns   eFlash_OK if no erase failed
+*            or
+*            eFlash_EraseError otherwise.
+*
+*******************************************************************************/
+BSP_RAMFUNC eFlashError_t FlashEraseRun(void)
+{
+    return FlashEraseNext(0xFFFFFFFFUL);
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashUnlock(void)
+* @brief Unlock flash for erase and program operations.
+*
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+eFlashError_t FlashUnlock(void)
 {
     uint32_t flashWait = BootTIMEOUT;
-    uint32_t flashAdr = (uint32_t)BSP_ABSOLUTE_APP_START;
-    
-    // Unlock Flash
+
+    /** The key sequence is only written to locked flash, a second sequence locks up the interface */
+    if((FLASH->CR & FLASH_CR_LOCK) == 0)
+    {
+        return eFlash_OK;
+    }
     FLASH->KEYR = FLASH_KEY1;
     FLASH->KEYR = FLASH_KEY2;
     while((FLASH->CR & FLASH_CR_LOCK) != 0)
@@ -134,30 +517,151 @@ eFlashError_t FlashErase(void)
             return eFlash_WriteTimeOut;
         }
     }
-    for(uint8_t i = 0; i < FlashSettings.TOTALPages; i++)
+    return eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashErasePage(const uint16_t pageNo)
+* @brief Erase one page of the application area, flash has to be unlocked.
+*
+* @param[in] pageNo page number counted from the start of application
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+BSP_RAMFUNC eFlashError_t FlashErasePage(const uint16_t pageNo)
+{
+    uint32_t flashWait = BootTIMEOUT;
+
+    eFlashError_t eFlashError;
+
+    if(pageNo >= FlashSettings.TOTALPages)
+    {
+        return eFlash_AddressError;
+    }
+    /** The erase running in the background is completed, the page itself is not erased twice */
+    eFlashError = FlashEraseWait(BSP_ABSOLUTE_APP_START);
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
+    EraseMask &= ~(1UL << pageNo);
+    FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR = BSP_ABSOLUTE_APP_START + ((uint32_t)pageNo * BSP_FLASH_PAGE_SIZE_BYTES);
+    FLASH->CR |= FLASH_CR_STRT;
+    while((FLASH->SR & FLASH_SR_BSY) != 0)
+    {
+        if(!(flashWait--))
+        {
+            return eFlash_WriteTimeOut;
+        }
+    }
+    FLASH->CR &= ~FLASH_CR_PER;
+    if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0)
     {
         FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
-        FLASH->CR |= FLASH_CR_PER;
-        FLASH->AR = flashAdr;
-        FLASH->CR |= FLASH_CR_STRT;
-        /** Reload the busy wait time out */
-        flashWait = BootTIMEOUT;
-        while((FLASH->SR & FLASH_SR_BSY) != 0)
+        return eFlash_EraseError;
+    }
+    return eFlash_OK;
+}
+
+#if defined(SELECT_DELTA)
+/******************************************************************************/
+/**
+* eFlashError_t FlashUpdatePage(uint8_t* buf, const uint16_t pageNo)
+* @brief Replace the content of one page of the application area. The page is
+*        only erased and programmed if the content differs from flash.
+*
+* @param[in] buf pointer to one page of data
+* @param[in] pageNo page number counted from the start of application
+* @returns   eFlash_OK if successful
+*            or
+*            eFlash_LastAddress if the last page of program flash is updated
+*            or
+*            error otherwise.
+*
+*******************************************************************************/
+eFlashError_t FlashUpdatePage(uint8_t* buf, const uint16_t pageNo)
+{
+    eFlashError_t eFlashError;
+
+    if((pageNo >= FlashSettings.TOTALPages) || (buf == NULL))
+    {
+        return eFlash_AddressError;
+    }
+    if(memcmp((const void *)(BSP_ABSOLUTE_APP_START + ((uint32_t)pageNo * BSP_FLASH_PAGE_SIZE_BYTES)),
+              buf, BSP_FLASH_PAGE_SIZE_BYTES) == 0)
+    {
+        return (pageNo == (FlashSettings.TOTALPages - 1U)) ? eFlash_LastAddress : eFlash_OK;
+    }
+    eFlashError = FlashErasePage(pageNo);
+    if(eFlash_OK == eFlashError)
+    {
+        eFlashError = FlashWrite(buf, BSP_FLASH_PAGE_SIZE_BYTES, pageNo);
+    }
+    return eFlashError;
+}
+#endif // SELECT_DELTA
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashResume(uint16_t *pPageNo)
+* @brief Find the page where an interrupted update has to continue and start
+*        erasing it and all pages after it. The journal in the last page marks
+*        each page which was written or kept completely in sequence, the first
+*        page without a mark may be half erased or hold a half programmed
+*        halfword. Without an open journal the update starts again at page 0.
+*        All blocks from the page on have to be sent again, kept pages included.
+*
+* @param[out] pPageNo first page which has to be sent again
+* @returns   eFlash_OK if successful
+*            or
+*            error otherwise.
+*
+*******************************************************************************/
+eFlashError_t FlashResume(uint16_t *pPageNo)
+{
+    const uint16_t *pJournal = (const uint16_t *)FlashSettings.JOURNALinFlash;
+    const uint16_t lastPage = (uint16_t)(FlashSettings.TOTALPages - 1UL);
+    uint16_t pageNo = 0U;
+    eFlashError_t eFlashError;
+
+    if(pPageNo == NULL)
+    {
+        return eFlash_AddressError;
+    }
+    *pPageNo = 0U;
+    if(pJournal[0] != FLASH_JOURNAL_OPEN)
+    {
+        return FlashEraseStart(FLASH_ALL_PAGES);
+    }
+    while((pageNo < lastPage) && (pJournal[1U + pageNo] == 0x0000U))
+    {
+        pageNo++;
+    }
+    if(pageNo == lastPage)
+    {
+        /** Erasing the last page clears the journal, the pages before are marked again */
+        eFlashError = FlashEraseStart(1UL << lastPage);
+        if(eFlash_OK == eFlashError)
         {
-            if(!(flashWait--))
-            {
-                return eFlash_WriteTimeOut;
-            }
+            eFlashError = FlashJournalAdvance(BSP_ABSOLUTE_APP_START, (uint32_t)lastPage * BSP_FLASH_PAGE_SIZE_BYTES);
         }
-        FLASH->CR &= ~FLASH_CR_PER;
-        if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0)
+    }else
+    {
+        eFlashError = FlashEraseSetup((FLASH_ALL_PAGES << pageNo) & ~(1UL << lastPage));
+        if(eFlash_OK == eFlashError)
         {
-            FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
-            return eFlash_EraseError;
+            JournalNext = BSP_ABSOLUTE_APP_START + ((uint32_t)pageNo * BSP_FLASH_PAGE_SIZE_BYTES);
+            JournalPages = pageNo;
         }
-        flashAdr = flashAdr + BSP_FLASH_PAGE_SIZE_BYTES;
     }
-    return eFlash_OK;
+    if(eFlash_OK == eFlashError)
+    {
+        *pPageNo = pageNo;
+    }
+    return eFlashError;
 }
 
 /******************************************************************************/
@@ -185,6 +689,12 @@ eFlashError_t FlashWriteFWParam(tFIRMWARE_PARAM fwParam)
 {
     uint32_t flashWait = BootTIMEOUT;
     uint16_t *ad = (uint16_t *)FlashSettings.CRCinFlash;
+    eFlashError_t eFlashError = FlashEraseWait(FlashSettings.LENinFlash + sizeof(uint16_t));
+
+    if(eFlash_OK != eFlashError)
+    {
+        return eFlashError;
+    }
     FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
     /* Write FW CRC */
     FLASH->CR |= FLASH_CR_PG;
@@ -232,46 +742,463 @@ eFlashError_t FlashWriteFWParam(tFIRMWARE_PARAM fwParam)
     {
         return eFlash_ReadError;
     }
-    return eFlash_OK;
+    /** The update is complete and is not resumed any more */
+    return FlashJournalClose();
 }
 
 /******************************************************************************/
 /**
 * eFlashError_t FlashVerifyFirmware(void)
 * @brief Verify firmware in Flash by comparing the stored crc with the 
-*        calculated crc.
+*        calculated crc, see FlashVerifyImage. The core clock cycles the check
+*        takes are measured with SysTick, see FlashVerifyCycles.
 *
 * @returns   eFlash_OK if matches
 *
 *******************************************************************************/
 eFlashError_t FlashVerifyFirmware(void)
 {
-    volatile uint16_t i = 0;
+    eFlashError_t eFlashError;
+    uint32_t remaining;
+
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+    eFlashError = FlashVerifyImage();
+    remaining = SysTick->VAL;
+    /** A wrap of the 24 bit counter saturates the count */
+    VerifyCycles = ((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0UL) ? 0xFFFFFFFFUL : (SysTick_LOAD_RELOAD_Msk - remaining);
+    /** The application finds SysTick as after reset */
+    SysTick->CTRL = 0UL;
+    SysTick->VAL = 0UL;
+    /** A verified update is not resumed any more, flash is only unlocked during an update */
+    if((eFlash_OK == eFlashError) && ((FLASH->CR & FLASH_CR_LOCK) == 0))
+    {
+        eFlashError = FlashJournalClose();
+    }
+
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* uint32_t FlashVerifyCycles(void)
+* @brief Core clock cycles the last FlashVerifyFirmware took.
+*
+* @returns   number of cycles, 0xFFFFFFFF if more than SysTick can count
+*
+*******************************************************************************/
+uint32_t FlashVerifyCycles(void)
+{
+    return VerifyCycles;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashVerifyPolicy(const uint16_t policy)
+* @brief Select when data written by FlashWrite is read back, for the
+*        following writes.
+*
+* @param[in] policy eVerify_Block, eVerify_Page or eVerify_Image
+* @returns   eFlash_OK if successful
+*            or
+*            eFlash_AddressError if the policy is unknown.
+*
+*******************************************************************************/
+eFlashError_t FlashVerifyPolicy(const uint16_t policy)
+{
+    if(policy > eVerify_Image)
+    {
+        return eFlash_AddressError;
+    }
+    VerifyPolicy = (eFlashVerify_t)policy;
+    PageNext = 0UL;
+    return eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashVerify_t FlashVerifyPolicyGet(void)
+* @brief Policy selected by FlashVerifyPolicy.
+*
+* @returns   verify policy
+*
+*******************************************************************************/
+eFlashVerify_t FlashVerifyPolicyGet(void)
+{
+    return VerifyPolicy;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashVerifyImage(void)
+* @brief Compare the stored crc with the calculated crc. Images with
+*        FW_PARAM_CRC32 in the length are checked with CRC-32 by the CRC unit,
+*        others with CRCCalc16, each in one call over the whole image. If the
+*        image was written in sequence after FlashEraseImage, the CRC
+*        accumulated during the update is compared, unless data was written
+*        without being read back. Define FLASH_VERIFY_READBACK to always read
+*        the image back. The image ends at the journal, a length up to the
+*        firmware parameters is refused.
+*
+* @returns   eFlash_OK if matches
+*
+*******************************************************************************/
+static eFlashError_t FlashVerifyImage(void)
+{
     uint32_t temp32 = *(uint32_t *)FlashSettings.CRCinFlash;
-    volatile const uint16_t lenFromHost = (uint16_t)(temp32 >> 16U);
-    volatile const uint16_t crcFromHost = (uint16_t)(temp32 & 0x0000FFFFUL);
-    uint16_t dataByte = 0;
-    uint16_t CRCtemp = 0;
-    uint16_t *fwar = (uint16_t*)BSP_ABSOLUTE_APP_START;
+    const uint16_t lenFromHost = (uint16_t)(temp32 >> 16U);
+    const uint16_t crcFromHost = (uint16_t)(temp32 & 0x0000FFFFUL);
     /* Read from FLASH_CRC_LENGTH_ADDRESS the firmware crc and length from host */
 
-    /** Check if the length is within flash range or the read flash will fail */
-    if(lenFromHost > (FlashSettings.CRCinFlash - BSP_ABSOLUTE_APP_START))
+#if !defined(FLASH_VERIFY_READBACK)
+    /** The whole image was written in sequence during this update, its CRC is known without reading it back */
+    if((ImageNext != 0UL) && (ImageUnverified == 0U) && ((ImageNext - BSP_ABSOLUTE_APP_START) >= ImageLength) &&
+       ((lenFromHost & ~FW_PARAM_CRC32) == ImageLength))
     {
-        return eFlash_AddressError;
+        if((lenFromHost & FW_PARAM_CRC32) != 0U)
+        {
+            return (((ImageLength % sizeof(uint32_t)) == 0U) && (ImageCRC32 == *(uint32_t *)FlashSettings.CRC32inFlash)) ?
+                   eFlash_OK : eFlash_ReadError;
+        }
+        if((ImageLength % sizeof(uint16_t)) == 0U)
+        {
+            return (ImageCRC16 == crcFromHost) ? eFlash_OK : eFlash_ReadError;
+        }
     }
+#endif
 
-    /* Calculate local crc */
-    while(i < lenFromHost) 
+    if((lenFromHost & FW_PARAM_CRC32) != 0U)
     {
-        /* Read from address of the firmware and calculate crc */
-        dataByte = *fwar++;
-        CRCtemp = CRCCalc16((uint8_t *)&dataByte, 2, CRCtemp);
-        i += 2;
+        temp32 = lenFromHost & ~FW_PARAM_CRC32;
+        if((temp32 > (FlashSettings.JOURNALinFlash - BSP_ABSOLUTE_APP_START)) || ((temp32 % sizeof(uint32_t)) != 0U))
+        {
+            return eFlash_AddressError;
+        }
+        if(CRCCalc32((const uint32_t *)BSP_ABSOLUTE_APP_START, temp32 / sizeof(uint32_t), 0UL) == *(uint32_t *)FlashSettings.CRC32inFlash)
+        {
+            return eFlash_OK;
+        }
+        return eFlash_ReadError;
     }
-    if(CRCtemp == crcFromHost)
+
+    /** Check if the length is within flash range or the read flash will fail, the journal
+     *  below the firmware parameters is programmed during the update and is not part of it */
+    if(lenFromHost > (FlashSettings.JOURNALinFlash - BSP_ABSOLUTE_APP_START))
+    {
+        return eFlash_AddressError;
+    }
+
+    /* Calculate local crc over whole halfwords straight from flash */
+    if(CRCCalc16((const uint8_t *)BSP_ABSOLUTE_APP_START, (lenFromHost + 1U) & ~1U, 0U) == crcFromHost)
     {
         return eFlash_OK;
     }
     return eFlash_ReadError;
 }
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashProgram(uint16_t *p16, const uint8_t *buf, const uint16_t size, const uint8_t verify)
+* @brief Program and verify consecutive halfwords of unlocked flash. Runs from
+*        SRAM, programming is enabled once for the whole range and halfwords
+*        which already hold the value are skipped.
+*
+* @param[in] p16 address in flash
+* @param[in] buf pointer to data to be written to flash
+* @param[in] size number of bytes, multiple of two
+* @param[in] verify 1 to read back each programmed halfword
+* @returns   eFlash_OK if successful
+*            or
+*            error otherwise.
+*
+*******************************************************************************/
+static BSP_RAMFUNC eFlashError_t FlashProgram(uint16_t *p16, const uint8_t *buf, const uint16_t size, const uint8_t verify)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+    const uint8_t *pEnd = buf + size;
+    uint32_t flashWait;
+    uint16_t data;
+
+    FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+    FLASH->CR |= FLASH_CR_PG;
+    for(; buf < pEnd; buf += sizeof(uint16_t), p16++)
+    {
+        data = (uint16_t)(buf[1] << 8) | buf[0];
+        if(*p16 == data)
+        {
+            continue;
+        }
+        *p16 = data;
+        flashWait = BootTIMEOUT;
+        while((FLASH->SR & FLASH_SR_BSY) != 0)
+        {
+            if(!(flashWait--))
+            {
+                eFlashError = eFlash_WriteTimeOut;
+                break;
+            }
+        }
+        if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0)
+        {
+            FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+            eFlashError = eFlash_WriteError;
+        }
+        else if((eFlash_OK == eFlashError) && (verify != 0U) && (*p16 != data))
+        {
+            eFlashError = eFlash_ReadError;
+        }
+        if(eFlash_OK != eFlashError)
+        {
+            break;
+        }
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashProgramHalfWord(uint16_t *p16, const uint16_t data)
+* @brief Program one halfword of unlocked flash. A halfword which already holds
+*        the value, e.g. 0xFFFF in erased flash or an unchanged halfword of a
+*        kept page, is not programmed.
+*
+* @param[in] p16 address in flash
+* @param[in] data halfword to be written
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+static BSP_RAMFUNC eFlashError_t FlashProgramHalfWord(uint16_t *p16, const uint16_t data)
+{
+    uint32_t flashWait = BootTIMEOUT;
+
+    if(*p16 == data)
+    {
+        return eFlash_OK;
+    }
+    FLASH->CR |= FLASH_CR_PG;
+    *p16 = data;
+    while((FLASH->SR & FLASH_SR_BSY) != 0)
+    {
+        if(!(flashWait--))
+        {
+            /** Return if the busy wait timer expires */
+            return eFlash_WriteTimeOut;
+        }
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+    if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0)
+    {
+        FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+        return eFlash_WriteError;
+    }
+    return eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashEraseNext(const uint32_t pages)
+* @brief Step of the erase engine, never waits for flash. Completes the page
+*        erase which is in progress and starts the erase of the next pending
+*        page if it is one of the given pages.
+*
+* @param[in] pages bit n is set if page n may be started
+* @returns   eFlash_OK if no erase failed
+*            or
+*            eFlash_EraseError otherwise.
+*
+*******************************************************************************/
+static BSP_RAMFUNC eFlashError_t FlashEraseNext(const uint32_t pages)
+{
+    uint16_t pageNo = 0U;
+
+    if(EraseActive != 0UL)
+    {
+        if((FLASH->SR & FLASH_SR_BSY) != 0)
+        {
+            return EraseError;
+        }
+        FLASH->CR &= ~FLASH_CR_PER;
+        if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) != 0)
+        {
+            FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+            EraseError = eFlash_EraseError;
+            EraseMask = 0UL;
+        }
+        EraseMask &= ~EraseActive;
+        EraseActive = 0UL;
+    }
+    if(EraseMask != 0UL)
+    {
+        while((EraseMask & (1UL << pageNo)) == 0UL)
+        {
+            pageNo++;
+        }
+        if((pages & (1UL << pageNo)) != 0UL)
+        {
+            EraseActive = 1UL << pageNo;
+            FLASH->SR |= FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+            FLASH->CR |= FLASH_CR_PER;
+            FLASH->AR = BSP_ABSOLUTE_APP_START + ((uint32_t)pageNo * BSP_FLASH_PAGE_SIZE_BYTES);
+            FLASH->CR |= FLASH_CR_STRT;
+        }
+    }
+    return EraseError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashEraseWait(const uint32_t endAddress)
+* @brief Run the erase engine until all pages below an address are erased and
+*        no erase is in progress, so flash can be programmed. Pages above the
+*        address are not started. BSP_ABSOLUTE_APP_START only completes the
+*        erase in progress.
+*
+* @param[in] endAddress first address after the range which is written next
+* @returns   eFlash_OK if the range is erased
+*            or
+*            error otherwise.
+*
+*******************************************************************************/
+static BSP_RAMFUNC eFlashError_t FlashEraseWait(const uint32_t endAddress)
+{
+    uint32_t flashWait = BootTIMEOUT;
+    uint32_t pageNo = (endAddress - BSP_ABSOLUTE_APP_START - 1UL) / BSP_FLASH_PAGE_SIZE_BYTES;
+    uint32_t pages = (pageNo >= 31UL) ? 0xFFFFFFFFUL : ((2UL << pageNo) - 1UL);
+    uint32_t pending = EraseMask;
+
+    if(endAddress <= BSP_ABSOLUTE_APP_START)
+    {
+        pages = 0UL;
+    }
+    while((((EraseMask & pages) != 0UL) || (EraseActive != 0UL)) && (eFlash_OK == EraseError))
+    {
+        FlashEraseNext(pages);
+        /** The timeout applies to each page */
+        if(pending != EraseMask)
+        {
+            pending = EraseMask;
+            flashWait = BootTIMEOUT;
+        }
+        if(!(flashWait--))
+        {
+            return eFlash_WriteTimeOut;
+        }
+    }
+    return EraseError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashJournalOpen(void)
+* @brief Erase the last page of the application area and mark the journal of
+*        an update in progress. Flash has to be unlocked.
+*
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+static eFlashError_t FlashJournalOpen(void)
+{
+    eFlashError_t eFlashError = FlashErasePage((uint16_t)(FlashSettings.TOTALPages - 1UL));
+
+    JournalNext = 0UL;
+    JournalPages = 0U;
+    if(eFlash_OK == eFlashError)
+    {
+        eFlashError = FlashProgramHalfWord((uint16_t *)FlashSettings.JOURNALinFlash, FLASH_JOURNAL_OPEN);
+    }
+    if(eFlash_OK == eFlashError)
+    {
+        JournalNext = BSP_ABSOLUTE_APP_START;
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashJournalClose(void)
+* @brief Mark the journal in the last page as closed, an update which does not
+*        erase the last page or a complete update can not be resumed.
+*        Programming 0x0000 is allowed on flash which is not erased.
+*
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+static eFlashError_t FlashJournalClose(void)
+{
+    JournalNext = 0UL;
+    if(*(const uint16_t *)FlashSettings.JOURNALinFlash == FLASH_JOURNAL_OPEN)
+    {
+        return FlashProgramHalfWord((uint16_t *)FlashSettings.JOURNALinFlash, 0x0000U);
+    }
+    return eFlash_OK;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t FlashJournalAdvance(const uint32_t address, const uint32_t size)
+* @brief Mark the pages in the journal which are complete after data was
+*        written or kept in sequence. A gap or data written again does not
+*        move the journal. No erase may be in progress.
+*
+* @param[in] address address in flash the data was written to
+* @param[in] size number of bytes
+* @returns   eFlash_OK if successful
+*
+*******************************************************************************/
+static eFlashError_t FlashJournalAdvance(const uint32_t address, const uint32_t size)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+    uint32_t pages;
+
+    if((JournalNext == 0UL) || (address != JournalNext))
+    {
+        return eFlash_OK;
+    }
+    JournalNext += size;
+    pages = (JournalNext - BSP_ABSOLUTE_APP_START) / BSP_FLASH_PAGE_SIZE_BYTES;
+    /** The last page holds the journal, it is complete with the firmware parameters */
+    while((eFlash_OK == eFlashError) && (JournalPages < pages) && (JournalPages < (FlashSettings.TOTALPages - 1UL)))
+    {
+        eFlashError = FlashProgramHalfWord((uint16_t *)FlashSettings.JOURNALinFlash + 1U + JournalPages, 0x0000U);
+        JournalPages++;
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* void FlashImageAccumulate(const uint32_t address, const uint8_t *pData, const uint32_t size)
+* @brief Add data written to flash to the CRCs of the image. Data written again
+*        is skipped, a gap stops the accumulation for this update.
+*
+* @param[in] address address in flash the data was written to
+* @param[in] pData pointer to the data, in SRAM or flash
+* @param[in] size number of bytes
+*
+*******************************************************************************/
+static void FlashImageAccumulate(const uint32_t address, const uint8_t *pData, const uint32_t size)
+{
+    uint32_t bytes = BSP_ABSOLUTE_APP_START + ImageLength;
+
+    if((ImageNext == 0UL) || (address < ImageNext) || (ImageNext >= bytes))
+    {
+        return;
+    }
+    if(address != ImageNext)
+    {
+        ImageNext = 0UL;
+        return;
+    }
+    /** Only the bytes up to the length of the image, the last block may hold more */
+    bytes -= address;
+    if(bytes > size)
+    {
+        bytes = size;
+    }
+    ImageCRC16 = CRCCalc16(pData, (uint16_t)bytes, ImageCRC16);
+    /** The CRC unit reads words, flash is aligned and already holds the data */
+    ImageCRC32 = CRCCalc32((const uint32_t *)address, bytes / sizeof(uint32_t), ImageCRC32);
+    ImageNext += size;
+}
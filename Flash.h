@@ -15,13 +15,30 @@
 #include "Packet.h"
 
 /* *************** Constant / macro definitions ( #define ) *******************/
+/** Page mask selecting all pages of the application area */
+#define FLASH_ALL_PAGES         (0xFFFFFFFFUL)
+/** Bytes of the update journal below the firmware parameters, a header and one marker per page.
+ *  The journal takes the end of the application area: images end at JOURNALinFlash, the
+ *  length in the firmware parameters can not cover it and the page digest counts it as 0xFF */
+#define FLASH_JOURNAL_BYTES     (64UL)
+/** Journal header of an update in progress, 0x0000 once the firmware parameters are written */
+#define FLASH_JOURNAL_OPEN      (0xA55AU)
 /* ********************* Type definitions ( typedef ) *************************/
 typedef struct myFlash{
+    uint32_t    JOURNALinFlash;
+    uint32_t    CRC32inFlash;
     uint32_t    CRCinFlash;
     uint32_t    LENinFlash;
     uint32_t    TOTALPages;
 }tFlashLimits;
 
+/** When data written by FlashWrite is read back and compared */
+typedef enum flashverify{
+		eVerify_Block = 0,  /**< Each halfword right after it is programmed          */
+		eVerify_Page,       /**< CRC over each page written in sequence when complete */
+		eVerify_Image       /**< Only the whole image by FlashVerifyFirmware          */
+}eFlashVerify_t;
+
 typedef enum flasherrors{
 		eFlash_OK,
 		eFlash_AddressError,
@@ -36,11 +53,26 @@ typedef enum flasherrors{
 /* ********************** Global func/proc prototypes *************************/
 /*******************************************************************************/
 void FlashInit(tBSPType BSPType);
+uint16_t FlashAppPages(void);
 eFlashError_t FlashWrite(uint8_t* buf, const uint16_t size, const uint16_t pktNo);
-eFlashError_t FlashErase(void);
+eFlashError_t FlashFill(const uint16_t blockNo, const uint16_t count, const uint16_t size, const uint16_t pattern);
+eFlashError_t FlashKeep(const uint16_t blockNo, const uint16_t count, const uint16_t size);
+uint16_t FlashPageDigest(const uint16_t pageNo);
+eFlashError_t FlashEraseStart(const uint32_t pageMask);
+eFlashError_t FlashEraseImage(const uint16_t length);
+eFlashError_t FlashEraseRun(void);
+eFlashError_t FlashUnlock(void);
+eFlashError_t FlashErasePage(const uint16_t pageNo);
+#if defined(SELECT_DELTA)
+eFlashError_t FlashUpdatePage(uint8_t* buf, const uint16_t pageNo);
+#endif
+eFlashError_t FlashResume(uint16_t *pPageNo);
 void FlashLock(void);
 eFlashError_t FlashWriteFWParam(tFIRMWARE_PARAM fwParam);
 eFlashError_t FlashVerifyFirmware(void);
+uint32_t FlashVerifyCycles(void);
+eFlashError_t FlashVerifyPolicy(const uint16_t policy);
+eFlashVerify_t FlashVerifyPolicyGet(void);
 
 #endif
 
@@ -0,0 +1,266 @@
+/******************************************************************************/
+/**
+* @file IsoTp.c
+* @brief Implement ISO 15765-2 (ISO-TP) transport on CAN
+*
+* Each command, response and packet of the protocol is one ISO-TP message with
+* normal addressing on the node ID of the CAN driver. Messages up to 7 bytes are sent
+* as single frame, longer ones as first frame and consecutive frames with flow
+* control by the receiver.
+*
+*******************************************************************************/
+
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stddef.h>
+
+#include "Can.h"
+
+#include "IsoTp.h"
+
+#if defined(SELECT_CAN) && defined(SELECT_ISOTP)
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+/* ********************* Type definitions ( typedef ) *************************/
+/* *********************** Global data definitions ****************************/
+/* **************** Global constant definitions ( const ) *********************/
+/* ***************** Modul global data segment ( static ) *********************/
+static uint8_t  RxActive = 0U;      /** A first frame was received */
+static uint16_t RxLength = 0U;      /** Length of the message */
+static uint16_t RxIndex = 0U;       /** Bytes of the message received */
+static uint8_t  RxSN = 0U;          /** Expected sequence number */
+static uint8_t  RxBlock = 0U;       /** Consecutive frames left in the block */
+/* *************** Modul global constants ( static const ) ********************/
+/* **************** Local func/proc prototypes ( static ) *********************/
+static void IsoTpSendFlowControl(const uint8_t flowStatus);
+static void IsoTpPad(tCANData *pFrame, uint32_t length);
+/******************************************************************************/
+/**
+* void IsoTpSend(uint8_t *pTxData, uint16_t size)
+* @brief Send a message as single frame or segmented. Waits for the flow
+*        control of the host after the first frame and after each block.
+*
+* @param[in] pTxData pointer to the data to be transmitted
+* @param[in] size number of bytes
+*
+*******************************************************************************/
+void IsoTpSend(uint8_t *pTxData, uint16_t size)
+{
+    tCANData    Frame;
+    uint32_t    length;
+    uint32_t    i;
+    uint32_t    canWait;
+    uint16_t    index = 0U;
+    uint8_t     sn = 1U;
+    uint8_t     block = 0U;
+
+    if(size <= ISOTP_SF_MAX_LENGTH)
+    {
+        Frame.Byte[0] = ISOTP_PCI_SF | (uint8_t)size;
+        for(i = 0U; i < size; i++)
+        {
+            Frame.Byte[1U + i] = pTxData[i];
+        }
+        IsoTpPad(&Frame, 1U + size);
+        CanSendFrame(&Frame, CAN_MAX_DATA_LENGTH);
+        return;
+    }
+
+    Frame.Byte[0] = ISOTP_PCI_FF | (uint8_t)(size >> 8U);
+    Frame.Byte[1] = (uint8_t)size;
+    for(i = 0U; i < ISOTP_FF_DATA_LENGTH; i++)
+    {
+        Frame.Byte[2U + i] = pTxData[index++];
+    }
+    CanSendFrame(&Frame, CAN_MAX_DATA_LENGTH);
+
+    while(index < size)
+    {
+        if(block == 0U)
+        {
+            /** Wait for flow control, the host does not send data while it waits for our response */
+            canWait = BootTIMEOUT;
+            do
+            {
+                if(!(canWait--))
+                {
+                    return;        /** Return if the busy wait timer expires */
+                }
+            }while((CanRecvFrame(&Frame, &length) != eFunction_Ok) ||
+                   ((Frame.Byte[0] & 0xF0U) != ISOTP_PCI_FC) || ((Frame.Byte[0] & 0x0FU) == ISOTP_FS_WAIT));
+            if((Frame.Byte[0] & 0x0FU) != ISOTP_FS_CTS)
+            {
+                return;
+            }
+            /** Block size 0 means no further flow control */
+            block = (Frame.Byte[1] != 0U) ? Frame.Byte[1] : 0xFFU;
+        }
+        Frame.Byte[0] = ISOTP_PCI_CF | sn;
+        for(i = 0U; (i < ISOTP_CF_DATA_LENGTH) && (index < size); i++)
+        {
+            Frame.Byte[1U + i] = pTxData[index++];
+        }
+        IsoTpPad(&Frame, 1U + i);
+        CanSendFrame(&Frame, CAN_MAX_DATA_LENGTH);
+        sn = (sn + 1U) & 0x0FU;
+        if(block != 0xFFU)
+        {
+            block--;
+        }
+    }
+}
+
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN IsoTpRecv(uint8_t *pRxData, uint16_t size)
+*
+* @brief Reassemble a message from all received frames. A message of another
+*        length than expected or a consecutive frame out of sequence aborts
+*        the reception.
+*
+* @param[out] pRxData pointer to receive array buffer
+* @param[in]  size number of bytes of the message
+* @returns    eFunction_Ok if the message is complete
+*             or
+*             eFunction_Error if the message is aborted
+*             or
+*             eFunction_Timeout if more frames are expected.
+*
+*******************************************************************************/
+eFUNCTION_RETURN IsoTpRecv(uint8_t *pRxData, uint16_t size)
+{
+    tCANData    Frame;
+    uint32_t    length;
+    uint32_t    i;
+
+    while(CanRecvFrame(&Frame, &length) == eFunction_Ok)
+    {
+        if(length == 0U)
+        {
+            continue;
+        }
+        switch(Frame.Byte[0] & 0xF0U)
+        {
+            case ISOTP_PCI_SF:
+                RxActive = 0U;
+                if(((Frame.Byte[0] & 0x0FU) != size) || (length < (1U + size)))
+                {
+                    return eFunction_Error;
+                }
+                for(i = 0U; i < size; i++)
+                {
+                    pRxData[i] = Frame.Byte[1U + i];
+                }
+                return eFunction_Ok;
+
+            case ISOTP_PCI_FF:
+                RxActive = 0U;
+                RxLength = ((uint16_t)(Frame.Byte[0] & 0x0FU) << 8U) | Frame.Byte[1];
+                if((RxLength != size) || (length < CAN_MAX_DATA_LENGTH))
+                {
+                    IsoTpSendFlowControl(ISOTP_FS_OVFLW);
+                    return eFunction_Error;
+                }
+                for(i = 0U; i < ISOTP_FF_DATA_LENGTH; i++)
+                {
+                    pRxData[i] = Frame.Byte[2U + i];
+                }
+                RxIndex = ISOTP_FF_DATA_LENGTH;
+                RxSN = 1U;
+                RxBlock = ISOTP_BLOCK_SIZE;
+                RxActive = 1U;
+                IsoTpSendFlowControl(ISOTP_FS_CTS);
+                break;
+
+            case ISOTP_PCI_CF:
+                if(RxActive == 0U)
+                {
+                    break;
+                }
+                /** A lost frame must not shift the following data */
+                if((Frame.Byte[0] & 0x0FU) != RxSN)
+                {
+                    RxActive = 0U;
+                    return eFunction_Error;
+                }
+                for(i = 1U; (i < length) && (RxIndex < RxLength); i++)
+                {
+                    pRxData[RxIndex++] = Frame.Byte[i];
+                }
+                RxSN = (RxSN + 1U) & 0x0FU;
+                if(RxIndex >= RxLength)
+                {
+                    RxActive = 0U;
+                    return eFunction_Ok;
+                }
+                if(--RxBlock == 0U)
+                {
+                    /** All frames of the block are taken out of the ring buffer */
+                    RxBlock = ISOTP_BLOCK_SIZE;
+                    IsoTpSendFlowControl(ISOTP_FS_CTS);
+                }
+                break;
+
+            default:
+                /** Flow control frames are only expected while sending */
+                break;
+        }
+    }
+
+    return eFunction_Timeout;
+}
+
+/******************************************************************************/
+/**
+* void IsoTpReset(void)
+*
+* @brief Abort the message which is received and drop received frames
+*
+* @returns    none
+*
+*******************************************************************************/
+void IsoTpReset(void)
+{
+    RxActive = 0U;
+    CanReset();
+}
+
+/******************************************************************************/
+/**
+* void IsoTpSendFlowControl(const uint8_t flowStatus)
+*
+* @brief Send a flow control frame with our block size and separation time
+*
+* @param[in] flowStatus ISOTP_FS_CTS, ISOTP_FS_WAIT or ISOTP_FS_OVFLW
+*
+*******************************************************************************/
+static void IsoTpSendFlowControl(const uint8_t flowStatus)
+{
+    tCANData    Frame;
+
+    Frame.Byte[0] = ISOTP_PCI_FC | flowStatus;
+    Frame.Byte[1] = ISOTP_BLOCK_SIZE;
+    Frame.Byte[2] = ISOTP_ST_MIN;
+    IsoTpPad(&Frame, 3U);
+    CanSendFrame(&Frame, CAN_MAX_DATA_LENGTH);
+}
+
+/******************************************************************************/
+/**
+* void IsoTpPad(tCANData *pFrame, uint32_t length)
+*
+* @brief Fill the unused bytes of a frame
+*
+* @param[in] pFrame pointer to the frame
+* @param[in] length number of used bytes
+*
+*******************************************************************************/
+static void IsoTpPad(tCANData *pFrame, uint32_t length)
+{
+    while(length < CAN_MAX_DATA_LENGTH)
+    {
+        pFrame->Byte[length++] = ISOTP_PADDING;
+    }
+}
+
+#endif // SELECT_CAN && SELECT_ISOTP
@@ -0,0 +1,48 @@
+/******************************************************************************/
+/**
+* @file IsoTp.h
+* @brief Implement ISO 15765-2 (ISO-TP) transport on CAN
+*
+*******************************************************************************/
+
+#if defined(SELECT_CAN) && defined(SELECT_ISOTP)
+
+#ifndef ISOTP_H_
+#define ISOTP_H_
+
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+
+#include "BSP.h"
+#include "Common.h"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+#define ISOTP_PCI_SF               (0x00U)  // Single frame, length in the low nibble
+#define ISOTP_PCI_FF               (0x10U)  // First frame, 12 bit length
+#define ISOTP_PCI_CF               (0x20U)  // Consecutive frame, sequence number in the low nibble
+#define ISOTP_PCI_FC               (0x30U)  // Flow control, flow status in the low nibble
+#define ISOTP_FS_CTS               (0x00U)  // Flow status continue to send
+#define ISOTP_FS_WAIT              (0x01U)  // Flow status wait
+#define ISOTP_FS_OVFLW             (0x02U)  // Flow status overflow, the message is aborted
+#define ISOTP_SF_MAX_LENGTH        (7U)     // Data bytes of a single frame
+#define ISOTP_FF_DATA_LENGTH       (6U)     // Data bytes of a first frame
+#define ISOTP_CF_DATA_LENGTH       (7U)     // Data bytes of a consecutive frame
+#define ISOTP_PADDING              (0xCCU)  // Unused bytes of a frame
+/** Consecutive frames between two flow control frames. All frames of a block fit into the
+ *  receive ring buffer (length byte and 8 data bytes each), so a block is never lost while
+ *  flash is programmed and the host waits for the next flow control frame */
+#define ISOTP_BLOCK_SIZE           ((BSP_RX_RING_SIZE / 9U) - 1U)
+/** Minimum separation time in ms, frames are buffered by the receive interrupt */
+#define ISOTP_ST_MIN               (0U)
+/* ********************* Type definitions ( typedef ) *************************/
+/* ***************** Global data declarations ( extern ) **********************/
+/* ***** External parameter / constant declarations ( extern const ) **********/
+/* ********************** Global func/proc prototypes *************************/
+void IsoTpSend(uint8_t *pTxData, uint16_t size);
+eFUNCTION_RETURN IsoTpRecv(uint8_t *pRxData, uint16_t size);
+void IsoTpReset(void);
+
+#endif // ISOTP_H_
+
+#endif // SELECT_CAN && SELECT_ISOTP
@@ -0,0 +1,216 @@
+/******************************************************************************/
+/**
+* @file Lz.c
+* @brief Streaming LZSS decompressor for compressed firmware images
+*
+*******************************************************************************/
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "Lz.h"
+
+#if defined(SELECT_LZ)
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+/* ********************* Type definitions ( typedef ) *************************/
+/** State of the decompressor at the start of a packet */
+typedef struct {
+    uint16_t BlockNo;
+    uint16_t Fill;
+    uint8_t  Flags;
+    uint8_t  FlagBits;
+    uint8_t  RefLow;
+    uint8_t  RefPending;
+}tLzState;
+/* *********************** Global data definitions ****************************/
+/* **************** Global constant definitions ( const ) *********************/
+/* ***************** Modul global data segment ( static ) *********************/
+static uint8_t  Staging[BSP_FLASH_PAGE_SIZE_BYTES];
+static uint16_t BlockSize = BSP_FLASH_PAGE_SIZE_BYTES;
+static uint16_t BlockNo = 0U;
+static uint16_t Fill = 0U;
+static uint8_t  Flags = 0U;
+static uint8_t  FlagBits = 0U;
+static uint8_t  RefLow = 0U;
+static uint8_t  RefPending = 0U;
+static uint8_t  Done = 0U;
+static tLzState Saved;
+/* *************** Modul global constants ( static const ) ********************/
+/* **************** Local func/proc prototypes ( static ) *********************/
+static eFlashError_t LzPut(uint8_t data);
+static eFlashError_t LzCopy(uint16_t offset, uint16_t length);
+/******************************************************************************/
+/**
+* void LzInit(uint16_t blockSize)
+* @brief Reset the decompressor, output starts at the start of application.
+*
+* @param[in] blockSize number of decompressed bytes written to flash at once
+*
+*******************************************************************************/
+void LzInit(uint16_t blockSize)
+{
+    BlockSize = blockSize;
+    BlockNo = 0U;
+    Fill = 0U;
+    Flags = 0U;
+    FlagBits = 0U;
+    RefPending = 0U;
+    Done = 0U;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t LzDecode(const uint8_t *pData, uint16_t size)
+* @brief Decompress the next part of the compressed stream. Items may be split
+*        between two calls. If the part fails, the decompressor returns to the
+*        state before it, so the packet can be sent again.
+*
+* @param[in] pData pointer to compressed data
+* @param[in] size number of compressed bytes
+* @returns   eFlash_OK if all bytes are processed
+*            or
+*            eFlash_LastAddress if the last address of program flash is written
+*            or
+*            error of flash write or a corrupted stream otherwise.
+*
+*******************************************************************************/
+eFlashError_t LzDecode(const uint8_t *pData, uint16_t size)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+    uint16_t ref;
+
+    if(pData == NULL)
+    {
+        return eFlash_AddressError;
+    }
+    /** Padding behind the end of the image is ignored */
+    if(Done != 0U)
+    {
+        return eFlash_LastAddress;
+    }
+    Saved.BlockNo = BlockNo;
+    Saved.Fill = Fill;
+    Saved.Flags = Flags;
+    Saved.FlagBits = FlagBits;
+    Saved.RefLow = RefLow;
+    Saved.RefPending = RefPending;
+    while((size > 0U) && (eFlash_OK == eFlashError))
+    {
+        if(FlagBits == 0U)
+        {
+            Flags = *pData;
+            FlagBits = 8U;
+        }
+        else if(RefPending != 0U)
+        {
+            ref = (uint16_t)((uint16_t)*pData << 8) | RefLow;
+            RefPending = 0U;
+            Flags >>= 1;
+            FlagBits--;
+            eFlashError = LzCopy((ref & LZ_OFFSET_MASK) + 1U, (ref >> LZ_OFFSET_BITS) + LZ_MIN_MATCH);
+        }
+        else if((Flags & 1U) != 0U)
+        {
+            Flags >>= 1;
+            FlagBits--;
+            eFlashError = LzPut(*pData);
+        }
+        else
+        {
+            RefLow = *pData;
+            RefPending = 1U;
+        }
+        pData++;
+        size--;
+    }
+    if(eFlash_LastAddress == eFlashError)
+    {
+        Done = 1U;
+    }
+    else if(eFlash_OK != eFlashError)
+    {
+        /** Blocks completed by the packet are in flash, the part of the first one
+         *  which was buffered before the packet is read back */
+        if(BlockNo != Saved.BlockNo)
+        {
+            memcpy(Staging, (const void *)(BSP_ABSOLUTE_APP_START + ((uint32_t)Saved.BlockNo * BlockSize)), Saved.Fill);
+        }
+        BlockNo = Saved.BlockNo;
+        Fill = Saved.Fill;
+        Flags = Saved.Flags;
+        FlagBits = Saved.FlagBits;
+        RefLow = Saved.RefLow;
+        RefPending = Saved.RefPending;
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t LzPut(uint8_t data)
+* @brief Append one decompressed byte, write the block to flash when it is full.
+*        The next block is only started if the write was successful.
+*
+* @param[in] data decompressed byte
+* @returns   result of the flash write or eFlash_OK
+*
+*******************************************************************************/
+static eFlashError_t LzPut(uint8_t data)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+
+    Staging[Fill++] = data;
+    if(Fill >= BlockSize)
+    {
+        eFlashError = FlashWrite(Staging, BlockSize, BlockNo);
+        if((eFlash_OK == eFlashError) || (eFlash_LastAddress == eFlashError))
+        {
+            BlockNo++;
+            Fill = 0U;
+        }
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t LzCopy(uint16_t offset, uint16_t length)
+* @brief Repeat bytes of the decompressed output. Bytes of earlier blocks are
+*        read from flash, bytes of the current block from the staging buffer.
+*
+* @param[in] offset distance to the first byte to be copied
+* @param[in] length number of bytes to be copied
+* @returns   eFlash_AddressError if the reference is before the image
+*            or
+*            result of LzPut() otherwise.
+*
+*******************************************************************************/
+static eFlashError_t LzCopy(uint16_t offset, uint16_t length)
+{
+    eFlashError_t eFlashError = eFlash_OK;
+    uint32_t blockStart;
+    uint32_t src;
+
+    while((length > 0U) && (eFlash_OK == eFlashError))
+    {
+        blockStart = (uint32_t)BlockNo * BlockSize;
+        if(offset > (blockStart + Fill))
+        {
+            return eFlash_AddressError;
+        }
+        src = blockStart + Fill - offset;
+        if(src >= blockStart)
+        {
+            eFlashError = LzPut(Staging[src - blockStart]);
+        }else
+        {
+            eFlashError = LzPut(*(const uint8_t *)(BSP_ABSOLUTE_APP_START + src));
+        }
+        length--;
+    }
+    return eFlashError;
+}
+
+#endif // SELECT_LZ
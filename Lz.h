@@ -0,0 +1,44 @@
+/******************************************************************************/
+/**
+* @file Lz.h
+* @brief Streaming LZSS decompressor for compressed firmware images
+*
+* Format of the compressed stream:
+* - A flag byte is followed by up to eight items, bit 0 of the flag byte
+*   describes the first item.
+* - Flag bit 1: the item is one literal byte.
+* - Flag bit 0: the item is a two-byte little endian back reference R which
+*   copies ((R >> 12) + 3) bytes starting ((R & 0x0FFF) + 1) bytes before the
+*   current output position.
+* The decompressed stream has to cover the complete application area like a
+* raw image. Decompressed data which is already programmed is read back from
+* flash as history, so only one block is buffered in RAM.
+*
+*******************************************************************************/
+#if defined(SELECT_LZ)
+
+#ifndef LZ_H
+#define LZ_H
+
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+
+#include "Flash.h"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+#define LZ_OFFSET_BITS          (12U)
+#define LZ_OFFSET_MASK          ((1U << LZ_OFFSET_BITS) - 1U)
+#define LZ_MIN_MATCH            (3U)
+/* ********************* Type definitions ( typedef ) *************************/
+/* ***************** Global data declarations ( extern ) **********************/
+/* ***** External parameter / constant declarations ( extern const ) **********/
+/* ********************** Global func/proc prototypes *************************/
+void LzInit(uint16_t blockSize);
+eFlashError_t LzDecode(const uint8_t *pData, uint16_t size);
+
+#endif
+
+#endif // SELECT_LZ
+
+/* end of Lz.h */
@@ -0,0 +1,190 @@
+/******************************************************************************/
+/**
+* @file Packet.c
+* @brief Receive window for the pipelined transfer of data packets
+*
+*******************************************************************************/
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CRC.h"
+
+#include "Packet.h"
+
+#if defined(SELECT_WINDOW) || defined(SELECT_MULTICAST)
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+/* ********************* Type definitions ( typedef ) *************************/
+/* *********************** Global data definitions ****************************/
+/* **************** Global constant definitions ( const ) *********************/
+/* ***************** Modul global data segment ( static ) *********************/
+static uint32_t     Pool[PACKET_POOL_SIZE / sizeof(uint32_t)];
+static uint8_t      SlotUsed[PACKET_WINDOW_SIZE];
+static uint16_t     Slots = 1U;
+static uint16_t     BlockSize = BLOCK_SIZE;
+static uint16_t     SeqExpected = 0U;
+/* *************** Modul global constants ( static const ) ********************/
+/* **************** Local func/proc prototypes ( static ) *********************/
+/******************************************************************************/
+/**
+* uint16_t PacketInit(uint16_t blockSize, uint16_t seqStart)
+* @brief Empty the receive window, split the packet pool into slots for the
+*        negotiated block size and expect the packet with sequence count seqStart.
+*
+* @param[in] blockSize number of data bytes in each packet
+* @param[in] seqStart sequence count of the first packet, 0 unless an update is resumed
+* @returns   number of packets which can be buffered
+*
+*******************************************************************************/
+uint16_t PacketInit(uint16_t blockSize, uint16_t seqStart)
+{
+    BlockSize = blockSize;
+    Slots = PACKET_POOL_SIZE / (blockSize + PACKET_OVERHEAD);
+    if(Slots > PACKET_WINDOW_SIZE)
+    {
+        Slots = PACKET_WINDOW_SIZE;
+    }
+    for(uint16_t i = 0U; i < PACKET_WINDOW_SIZE; i++)
+    {
+        SlotUsed[i] = 0U;
+    }
+    SeqExpected = seqStart;
+
+    return Slots;
+}
+
+/******************************************************************************/
+/**
+* ePACKET_STATUS PacketProcess(const uint8_t *pPacket)
+* @brief Check the CRC of a received packet and buffer it in the slot of its
+*        sequence count. Packets may arrive in any order as long as they are
+*        inside the window starting at the next expected sequence count.
+*
+* @param[in] pPacket pointer to the received packet
+* @returns   ePACKET_Ok if the packet is buffered or was already written
+*            or
+*            ePACKET_CRCError if the packet is corrupted
+*            or
+*            ePACKET_SNError if the sequence count is outside of the window.
+*
+*******************************************************************************/
+ePACKET_STATUS PacketProcess(const uint8_t *pPacket)
+{
+    uint16_t seqCnt;
+    uint16_t slot;
+
+    if(pPacket == NULL)
+    {
+        return ePACKET_SNError;
+    }
+    if(CRCCalc16(pPacket, BlockSize + sizeof(uint16_t), 0) != PACKET_CRC(pPacket, BlockSize))
+    {
+        return ePACKET_CRCError;
+    }
+    seqCnt = PACKET_SEQCNT(pPacket, BlockSize) & ~PACKET_FILL_FLAG;
+    /** Retransmission of a packet which is already in flash, host missed our ack */
+    if(seqCnt < SeqExpected)
+    {
+        return ePACKET_Ok;
+    }
+    if(seqCnt >= (SeqExpected + Slots))
+    {
+        return ePACKET_SNError;
+    }
+    slot = seqCnt % Slots;
+    memcpy((uint8_t *)Pool + (slot * (BlockSize + PACKET_OVERHEAD)), pPacket, BlockSize + PACKET_OVERHEAD);
+    SlotUsed[slot] = 1U;
+
+    return ePACKET_Ok;
+}
+
+/******************************************************************************/
+/**
+* uint8_t* PacketNext(void)
+* @brief Get the packet with the next expected sequence count if it was received.
+*        A fill packet slides the window by all blocks it covers, a packet of
+*        one of these blocks may still be buffered in the slot and is dropped.
+*
+* @returns   pointer to the packet to be written to flash
+*            or
+*            NULL if the packet is still missing.
+*
+*******************************************************************************/
+uint8_t* PacketNext(void)
+{
+    uint16_t slot = SeqExpected % Slots;
+    uint8_t *pPacket = (uint8_t *)Pool + (slot * (BlockSize + PACKET_OVERHEAD));
+
+    if(SlotUsed[slot] == 0U)
+    {
+        return NULL;
+    }
+    if((PACKET_SEQCNT(pPacket, BlockSize) & ~PACKET_FILL_FLAG) != SeqExpected)
+    {
+        SlotUsed[slot] = 0U;
+        return NULL;
+    }
+    return pPacket;
+}
+
+/******************************************************************************/
+/**
+* void PacketRelease(void)
+* @brief Free the slot of the packet returned by PacketNext() after it was
+*        written and slide the window by one packet, or by all blocks covered
+*        by a fill packet.
+*
+*******************************************************************************/
+void PacketRelease(void)
+{
+    uint16_t slot = SeqExpected % Slots;
+    uint8_t *pPacket = (uint8_t *)Pool + (slot * (BlockSize + PACKET_OVERHEAD));
+
+    SlotUsed[slot] = 0U;
+    if(((PACKET_SEQCNT(pPacket, BlockSize) & PACKET_FILL_FLAG) != 0U) && (PACKET_FILL_COUNT(pPacket) != 0U))
+    {
+        SeqExpected += PACKET_FILL_COUNT(pPacket);
+    }else
+    {
+        SeqExpected++;
+    }
+}
+
+/******************************************************************************/
+/**
+* uint8_t* PacketSlot(uint16_t slot)
+* @brief Buffer of a slot of the pool for a packet received outside of the
+*        window, as the blocks of a multicast stream.
+*
+* @param[in] slot number of the slot
+* @returns   pointer to the buffer of the slot
+*            or
+*            NULL if the pool has not that many slots for the block size.
+*
+*******************************************************************************/
+uint8_t* PacketSlot(uint16_t slot)
+{
+    if(slot >= Slots)
+    {
+        return NULL;
+    }
+    return (uint8_t *)Pool + (slot * (BlockSize + PACKET_OVERHEAD));
+}
+
+/******************************************************************************/
+/**
+* uint16_t PacketExpected(void)
+* @brief Sequence count of the first packet which is not yet written.
+*
+* @returns   next expected sequence count
+*
+*******************************************************************************/
+uint16_t PacketExpected(void)
+{
+    return SeqExpected;
+}
+
+#endif // SELECT_WINDOW || SELECT_MULTICAST
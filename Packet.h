@@ -1,20 +1,56 @@
 /******************************************************************************/
 /**
 * @file Packet.h
-* @brief Definition of the 68-byte data packet and its' status
+* @brief Definition of the data packet and its' status
 *
 *******************************************************************************/
 #ifndef PACKET_H
 #define PACKET_H
 
 /* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+
+#include "BSP.h"
+
 /* *************** Constant / macro definitions ( #define ) *******************/
+/** Optional transfers, selected in the project like the target: SELECT_WINDOW pipelined
+ *  packets in the pool, SELECT_LZ and SELECT_DELTA decode them in order, SELECT_MULTICAST
+ *  takes the blocks of a stream to a group into two slots of the pool */
+#if (defined(SELECT_LZ) || defined(SELECT_DELTA)) && !defined(SELECT_WINDOW)
+#error "Compressed images and patches are sent windowed, define SELECT_WINDOW"
+#endif
 #define BLOCK_SIZE 64
+/** Largest block size which can be negotiated, one flash page */
+#define BLOCK_SIZE_MAX          (BSP_FLASH_PAGE_SIZE_BYTES)
+/** Two-byte sequence count and two-byte CRC following the data block */
+#define PACKET_OVERHEAD         (4U)
+/** Maximum number of data packets the host may have in flight in windowed mode */
+#define PACKET_WINDOW_SIZE      (8U)
+/** Bytes reserved for buffering packets in windowed mode, two packets of maximum size */
+#define PACKET_POOL_SIZE        (2U * (BLOCK_SIZE_MAX + PACKET_OVERHEAD))
+
+/** Sequence count flag of a fill packet, the remaining bits are the number of the first block.
+ *  The data of a fill packet holds the two-byte number of blocks and the two-byte fill pattern.
+ *  If PACKET_FILL_KEEP is set in the number of blocks, the blocks are kept as they are in flash. */
+#define PACKET_FILL_FLAG        (0x8000U)
+#define PACKET_FILL_KEEP        (0x8000U)
+#define PACKET_FILL_COUNT(pBuf) (*(uint16_t *)&((pBuf)[0]) & ~PACKET_FILL_KEEP)
+#define PACKET_FILL_IS_KEEP(pBuf) ((*(uint16_t *)&((pBuf)[0]) & PACKET_FILL_KEEP) != 0U)
+#define PACKET_FILL_PATTERN(pBuf) (*(uint16_t *)&((pBuf)[2]))
+
+/** Blocks of the smallest size in the application area, one bit each in multicast mode */
+#define PACKET_BLOCKS_MAX       ((BSP_FLASH_MAX_SIZE_32KB - BSP_BOOTLOADER_MAX_SIZE) / BLOCK_SIZE)
+
+/** Access sequence count and CRC of a packet with a block of blockSize bytes */
+#define PACKET_SEQCNT(pBuf, blockSize)  (*(uint16_t *)&((pBuf)[(blockSize)]))
+#define PACKET_CRC(pBuf, blockSize)     (*(uint16_t *)&((pBuf)[(blockSize) + 2U]))
 
 /* ********************* Type definitions ( typedef ) *************************/
 /**
 * @struct tDATA_PACKET
-* @brief Packet includes 64-byte blocks of data plus two-byte sequence count and two-byte CRC
+* @brief Packet includes 64-byte blocks of data plus two-byte sequence count and two-byte CRC.
+*        Packets with a negotiated block size keep this layout, see PACKET_SEQCNT.
 */
 typedef struct
 {
@@ -33,6 +69,89 @@ typedef struct
     uint16_t u16FWLen;    /**< Length of the firmware     */
 }tFIRMWARE_PARAM;
 
+/** Flag in the length of the firmware parameters, the image is checked with CRC-32, see tFIRMWARE_PARAM32 */
+#define FW_PARAM_CRC32          (0x8000U)
+
+/**
+* @struct tFIRMWARE_PARAM32
+* @brief Last 8 bytes of flash of an image checked with CRC-32 (as zlib crc32) over
+*        the firmware. The length is a multiple of four and has FW_PARAM_CRC32 set.
+*/
+typedef struct
+{
+    uint32_t u32FWCRC;    /**< CRC-32 over firmware              */
+    uint16_t u16Reserved; /**< 0xFFFF, CRC16 of tFIRMWARE_PARAM  */
+    uint16_t u16FWLen;    /**< Length of the firmware            */
+}tFIRMWARE_PARAM32;
+
+/**
+* @struct tRESPONSE_PARAM
+* @brief Four-byte response, response ID plus a two-byte parameter. In windowed
+*        mode eRES_OK acknowledges all packets before the sequence count in
+*        u16Param and eRES_Error requests the retransmission of u16Param.
+*/
+typedef struct
+{
+    uint16_t u16Response; /**< Response ID                 */
+    uint16_t u16Param;    /**< Parameter of the response   */
+}tRESPONSE_PARAM;
+
+/**
+* @struct tDIGEST_LIST
+* @brief CRC over each page of the new firmware plus two-byte CRC over the list.
+*        Lists for targets with less flash leave the remaining entries unused.
+*/
+typedef struct
+{
+    uint16_t u16Digest[BSP_APP_PROGRAM_PAGES_32KB]; /**< CRCCalc16 over each page */
+    uint16_t u16CRC;                                /**< Two-byte CRC of the list */
+}tDIGEST_LIST;
+
+/**
+* @struct tPAGE_MASK
+* @brief Response to a digest list, the pages which differ from the new firmware.
+*/
+typedef struct
+{
+    uint16_t u16Response;   /**< Response ID                        */
+    uint16_t u16Pages;      /**< Number of pages which differ       */
+    uint32_t u32PageMask;   /**< Bit n is set if page n differs     */
+}tPAGE_MASK;
+
+/**
+* @struct tBLOCK_RANGE
+* @brief Range of blocks the host asks for the missing ones after a multicast stream.
+*/
+typedef struct
+{
+    uint16_t u16First;      /**< Number of the first block          */
+    uint16_t u16Count;      /**< Number of blocks in the range      */
+}tBLOCK_RANGE;
+
+/**
+* @struct tMISSING_BLOCKS
+* @brief Response to a block range, the blocks which were not written.
+*/
+typedef struct
+{
+    uint16_t u16Response;   /**< Response ID                        */
+    uint16_t u16Count;      /**< Number of blocks missing           */
+    uint16_t u16Block[2];   /**< First missing blocks, else 0xFFFF  */
+}tMISSING_BLOCKS;
+
+/**
+* @struct tSESSION_STATUS
+* @brief Response to eCMD_Status, the settings of the session.
+*/
+typedef struct
+{
+    uint16_t u16Response;       /**< Response ID                                   */
+    uint16_t u16VerifyPolicy;   /**< Verify policy of written data, eFlashVerify_t */
+    uint16_t u16BlockSize;      /**< Negotiated block size                         */
+    uint16_t u16WindowSize;     /**< Packets which may be in flight                */
+    uint32_t u32VerifyCycles;   /**< Core clock cycles of the last image check     */
+}tSESSION_STATUS;
+
 /**
 * @enum ePACKET_STATUS
 * @brief Status of the data packet.
@@ -47,8 +166,12 @@ typedef enum
 /* ***************** Global data declarations ( extern ) **********************/
 /* ***** External parameter / constant declarations ( extern const ) **********/
 /* ********************** Global func/proc prototypes *************************/
-void PacketInit(void);
-ePACKET_STATUS PacketProcess(tDATA_PACKET packet);
+uint16_t PacketInit(uint16_t blockSize, uint16_t seqStart);
+ePACKET_STATUS PacketProcess(const uint8_t *pPacket);
+uint8_t* PacketNext(void);
+void PacketRelease(void);
+uint8_t* PacketSlot(uint16_t slot);
+uint16_t PacketExpected(void);
 
 #endif
 
@@ -8,21 +8,47 @@
 
 /* ***************** Header / include files ( #include ) **********************/
 
+#include <stddef.h>
+
 #include "CRC.h"
+#include "Delta.h"
 #include "Flash.h"
+#include "Lz.h"
 #include "Protocol.h"
 
 /* *************** Constant / macro definitions ( #define ) *******************/
+/** Polls without a complete packet of BLOCK_SIZE before the received bytes are dropped */
+#define PROTOCOL_RECV_TIMEOUT       (0xFFUL)
+/** The polls grow with the negotiated block size, a larger packet takes longer to arrive */
+#define PROTOCOL_RECV_POLLS(size)   ((PROTOCOL_RECV_TIMEOUT * ((size) + PACKET_OVERHEAD)) / (BLOCK_SIZE + PACKET_OVERHEAD))
 /* ********************* Type definitions ( typedef ) *************************/
 /* *********************** Global data definitions ****************************/
 /* **************** Global constant definitions ( const ) *********************/
 /* ***************** Modul global data segment ( static ) *********************/
 static tCmdUnion         Command;
 static tPldUnion         Payload;
+static tResUnion         Response;
+static tDigestUnion      Digest;
+static tMaskUnion        Mask;
+static tStatusUnion      Status;
+#if defined(SELECT_MULTICAST)
+static tMissingUnion     Missing;
+static uint32_t          BlockWritten[(PACKET_BLOCKS_MAX + 31U) / 32U];
+static uint8_t           MulticastSlot = 0U;
+#endif
+static uint16_t          BlockSize = BLOCK_SIZE;
+static tTransferMode     TransferMode = eTransferRaw;
+static uint32_t          PageMask = FLASH_ALL_PAGES;
+static uint16_t          ResumePage = 0U;
+static uint8_t           CheckedByInterface = 0U;
 static volatile uint32_t *AppVectorsInFlash = (volatile uint32_t *)BSP_ABSOLUTE_APP_START;
 static volatile uint32_t *AppVectorsInRAM   = (volatile uint32_t *)BSP_ABSOLUTE_SRAM_START;
 /* *************** Modul global constants ( static const ) ********************/
 /* **************** Local func/proc prototypes ( static ) *********************/
+static eFlashError_t PayloadCommit(const uint8_t *pPacket);
+static void SendStatus(const tBSPStruct *pBSP);
+static uint16_t WindowLimit(const tBSPStruct *pBSP);
+static void AppJump(const tBSPStruct *pBSP);
 
 
 /******************************************************************************/
@@ -46,6 +72,19 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
     static uint32_t     stickyTimer = 0U;
     static uint32_t     timeout = 0U;
     eFlashError_t       eFlashError = eFlash_OK;
+#if defined(SELECT_WINDOW)
+    ePACKET_STATUS      ePacketStatus = ePACKET_Ok;
+#endif
+#if defined(SELECT_MULTICAST)
+    uint32_t            blockNo;
+    uint32_t            blockEnd;
+#endif
+
+    /** Pages are erased in the background while packets are received, a failed
+     *  erase is reported by the write to that page. The code fetch from flash stalls
+     *  for the whole erase of a page, only the receive interrupts and DMA go on, so
+     *  all bytes in flight have to fit into the receive buffer, see WindowLimit */
+    FlashEraseRun();
 	
     switch(stateNow)
     {
@@ -56,6 +95,10 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
                 {
                     stateNext = eFlashEraseCMD;
                     tickCounter = 0;
+                    BlockSize = BLOCK_SIZE;
+                    PageMask = FLASH_ALL_PAGES;
+                    ResumePage = 0U;
+                    FlashVerifyPolicy(eVerify_Block);
                     Command.returnValue = eRES_Ready;
                     pBSP->pSend(Command.bufferCMD, 2);
                 }
@@ -78,7 +121,7 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
             {
                 if(Command.receivedvalue == eCMD_EraseFlash)
                 {
-                    eFlashError = FlashErase();
+                    eFlashError = FlashEraseStart(PageMask);
                     if(eFlash_OK == eFlashError)
                     {
                         stateNext = eWriteMemory;
@@ -89,6 +132,88 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
                     }
                     pBSP->pSend(Command.bufferCMD, 2);
                 }
+                else if(Command.receivedvalue == eCMD_KeepFlash)
+                {
+                    /** Only unlock, the pages are erased one by one when a delta update changes them */
+                    eFlashError = FlashUnlock();
+                    if(eFlash_OK == eFlashError)
+                    {
+                        stateNext = eWriteMemory;
+                        Command.returnValue = eRES_OK;
+                    }else
+                    {
+                        Command.returnValue = eRES_Error;
+                    }
+                    pBSP->pSend(Command.bufferCMD, 2);
+                }
+                else if(Command.receivedvalue == eCMD_PageDigest)
+                {
+                    stateNext = eReceiveDigest;
+                }
+                else if(Command.receivedvalue == eCMD_EraseImage)
+                {
+                    stateNext = eEraseImage;
+                }
+                else if(Command.receivedvalue == eCMD_Status)
+                {
+                    SendStatus(pBSP);
+                }
+                else if(Command.receivedvalue == eCMD_Resume)
+                {
+                    /** The journal in flash is the record of progress, the pages from the
+                     *  resume point on are erased and all their blocks are sent again */
+                    Response.Response.u16Response = eRES_Error;
+                    Response.Response.u16Param = 0U;
+                    pBSP->pReady(0U);
+                    eFlashError = FlashResume(&ResumePage);
+                    if(eFlash_OK == eFlashError)
+                    {
+                        stateNext = eWriteMemory;
+                        Response.Response.u16Response = eRES_OK;
+                        Response.Response.u16Param = (uint16_t)((ResumePage * BSP_FLASH_PAGE_SIZE_BYTES) / BlockSize);
+                    }
+                    pBSP->pSend(Response.bufferRES, sizeof(tResUnion));
+                    pBSP->pReady(1U);
+                }
+            }
+            break;
+
+        case eEraseImage:
+            if(pBSP->pRecv(Command.bufferCMD, 2) == eFunction_Ok)
+            {
+                stateNext = eFlashEraseCMD;
+                Command.returnValue = eRES_Error;
+                if(FlashEraseImage(Command.receivedvalue) == eFlash_OK)
+                {
+                    stateNext = eWriteMemory;
+                    Command.returnValue = eRES_OK;
+                }
+                pBSP->pSend(Command.bufferCMD, 2);
+            }
+            break;
+
+        case eReceiveDigest:
+            if(pBSP->pRecv(Digest.bufferDGST, sizeof(tDigestUnion)) == eFunction_Ok)
+            {
+                stateNext = eFlashEraseCMD;
+                Mask.Mask.u16Response = eRES_Error;
+                Mask.Mask.u16Pages = 0U;
+                Mask.Mask.u32PageMask = 0UL;
+                if(CRCCalc16(Digest.bufferDGST, sizeof(Digest.List.u16Digest), 0) == Digest.List.u16CRC)
+                {
+                    /** Only pages which differ from the new firmware are erased and need to be sent */
+                    for(uint16_t i = 0U; i < FlashAppPages(); i++)
+                    {
+                        if(FlashPageDigest(i) != Digest.List.u16Digest[i])
+                        {
+                            Mask.Mask.u32PageMask |= (1UL << i);
+                            Mask.Mask.u16Pages++;
+                        }
+                    }
+                    PageMask = Mask.Mask.u32PageMask;
+                    Mask.Mask.u16Response = eRES_OK;
+                }
+                pBSP->pSend(Mask.bufferMSK, sizeof(tMaskUnion));
             }
             break;
 
@@ -97,25 +222,168 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
             {
                 if(Command.receivedvalue == eCMD_WriteMemory)
                 {
-                    stateNext = ePayloadReceive;
-                    Payload.packet.u16SeqCnt = 0xFFFFU;
-                    Command.returnValue = eRES_OK;
+                    Command.returnValue = eRES_Error;
+                    if((BlockSize + PACKET_OVERHEAD) <= pBSP->RxBufferSize)
+                    {
+                        stateNext = ePayloadReceive;
+                        TransferMode = eTransferRaw;
+                        CheckedByInterface = 0U;
+                        PACKET_SEQCNT(Payload.bufferPLD, BlockSize) = 0xFFFFU;
+                        Command.returnValue = eRES_OK;
+                    }
                     pBSP->pSend(Command.bufferCMD, 2);
 					pBSP->pReset();
                 }
+                else if((Command.receivedvalue == eCMD_WriteWindow) || (Command.receivedvalue == eCMD_WriteCompressed) ||
+                        (Command.receivedvalue == eCMD_WriteDelta))
+                {
+                    /** Transfers which are not selected for this build or whose packets do not fit into the receive buffer are refused */
+                    Response.Response.u16Response = eRES_Error;
+                    Response.Response.u16Param = 0U;
+                    TransferMode = eTransferRaw;
+                    /** Compressed packets and patches have to be decoded exactly once and in order, so always windowed */
+#if defined(SELECT_LZ)
+                    if(Command.receivedvalue == eCMD_WriteCompressed)
+                    {
+                        TransferMode = eTransferCompressed;
+                        LzInit(BlockSize);
+                    }
+#endif
+#if defined(SELECT_DELTA)
+                    if(Command.receivedvalue == eCMD_WriteDelta)
+                    {
+                        TransferMode = eTransferDelta;
+                        DeltaInit();
+                    }
+#endif
+#if defined(SELECT_WINDOW)
+                    if(((Command.receivedvalue == eCMD_WriteWindow) || (TransferMode != eTransferRaw)) &&
+                       ((BlockSize + PACKET_OVERHEAD) <= pBSP->RxBufferSize))
+                    {
+                        stateNext = ePayloadReceiveWindow;
+                        /** A resumed raw image continues at the first page which was not complete, the
+                         *  block size may have changed since the resume point was reported */
+                        Response.Response.u16Param = PacketInit(BlockSize, (TransferMode == eTransferRaw) ?
+                                                                (uint16_t)((ResumePage * BSP_FLASH_PAGE_SIZE_BYTES) / BlockSize) : 0U);
+                        PACKET_SEQCNT(Payload.bufferPLD, BlockSize) = 0xFFFFU;
+                        /** Tell the host how many packets it may send without waiting for an ack */
+                        Response.Response.u16Response = eRES_OK;
+                        if(WindowLimit(pBSP) < Response.Response.u16Param)
+                        {
+                            Response.Response.u16Param = WindowLimit(pBSP);
+                        }
+                    }
+#endif
+                    pBSP->pSend(Response.bufferRES, sizeof(tResUnion));
+                    pBSP->pReset();
+                }
+                else if(Command.receivedvalue == eCMD_WriteChecked)
+                {
+                    /** The interface hardware checks the CRC during the transfer, see pRecvChecked */
+                    Command.returnValue = eRES_Error;
+                    if(pBSP->pRecvChecked != NULL)
+                    {
+                        stateNext = ePayloadReceive;
+                        TransferMode = eTransferRaw;
+                        CheckedByInterface = 1U;
+                        PACKET_SEQCNT(Payload.bufferPLD, BlockSize) = 0xFFFFU;
+                        Command.returnValue = eRES_OK;
+                    }
+                    pBSP->pSend(Command.bufferCMD, 2);
+                    pBSP->pReset();
+                }
+                else if(Command.receivedvalue == eCMD_WriteMulticast)
+                {
+                    /** Blocks come from a stream to all nodes of a group, nothing is acknowledged */
+                    Command.returnValue = eRES_Error;
+#if defined(SELECT_MULTICAST)
+                    if(pBSP->pRecvChecked != NULL)
+                    {
+                        stateNext = ePayloadMulticast;
+                        TransferMode = eTransferRaw;
+                        for(uint16_t i = 0U; i < (sizeof(BlockWritten) / sizeof(BlockWritten[0])); i++)
+                        {
+                            BlockWritten[i] = 0UL;
+                        }
+                        /** Two slots of the pool take the blocks in turn, the pool holds two of the largest block */
+                        (void)PacketInit(BlockSize, 0U);
+                        MulticastSlot = 0U;
+                        Command.returnValue = eRES_OK;
+                    }
+#endif
+                    pBSP->pSend(Command.bufferCMD, 2);
+                    pBSP->pReset();
+                }
+                else if(Command.receivedvalue == eCMD_SetBlockSize)
+                {
+                    stateNext = eSetBlockSize;
+                }
+                else if(Command.receivedvalue == eCMD_VerifyPolicy)
+                {
+                    stateNext = eSetVerifyPolicy;
+                }
+                else if(Command.receivedvalue == eCMD_Status)
+                {
+                    SendStatus(pBSP);
+                }
+            }
+            break;
+
+        case eSetVerifyPolicy:
+            if(pBSP->pRecv(Command.bufferCMD, 2) == eFunction_Ok)
+            {
+                stateNext = eWriteMemory;
+                /** Trades the read back of each block against later detection of a write error */
+                Command.returnValue = (FlashVerifyPolicy(Command.receivedvalue) == eFlash_OK) ? eRES_OK : eRES_Error;
+                pBSP->pSend(Command.bufferCMD, 2);
+            }
+            break;
+
+        case eSetBlockSize:
+            if(pBSP->pRecv(Command.bufferCMD, 2) == eFunction_Ok)
+            {
+                stateNext = eWriteMemory;
+                /** Block size must be a power of two so that blocks never straddle a flash page. A packet
+                 *  has to fit into the receive buffer, unless the interface places it, see pRecvChecked */
+                if((Command.receivedvalue < BLOCK_SIZE) || (Command.receivedvalue > BLOCK_SIZE_MAX) ||
+                   ((Command.receivedvalue & (Command.receivedvalue - 1U)) != 0U) ||
+                   (((Command.receivedvalue + PACKET_OVERHEAD) > pBSP->RxBufferSize) && (pBSP->pRecvChecked == NULL)))
+                {
+                    Command.returnValue = eRES_Error;
+                }else
+                {
+                    BlockSize = Command.receivedvalue;
+                    Command.returnValue = eRES_OK;
+                }
+                pBSP->pSend(Command.bufferCMD, 2);
             }
             break;
 
         case ePayloadReceive:
-            retVal = pBSP->pRecv(Payload.bufferPLD, sizeof(tPldUnion));
+            if(CheckedByInterface != 0U)
+            {
+                retVal = pBSP->pRecvChecked(Payload.bufferPLD, BlockSize + PACKET_OVERHEAD);
+            }else
+            {
+                retVal = pBSP->pRecv(Payload.bufferPLD, BlockSize + PACKET_OVERHEAD);
+            }
             stateNext = ePayloadReceive;
-            if(retVal == eFunction_Ok)
+            if((retVal == eFunction_Ok) || (retVal == eFunction_Error))
             {
                 timeout = 0U;
-                crcCalculated = CRCCalc16(Payload.packet.u8Data, 66U, 0);
-                if(crcCalculated == Payload.packet.u16CRC)
+                /** Busy until the packet is in flash and the response is sent */
+                pBSP->pReady(0U);
+                if((retVal == eFunction_Ok) && (CheckedByInterface == 0U))
                 {
-                    eFlashError = FlashWrite(Payload.bufferPLD, BLOCK_SIZE, Payload.packet.u16SeqCnt); 
+                    crcCalculated = CRCCalc16(Payload.bufferPLD, BlockSize + sizeof(uint16_t), 0);
+                    if(crcCalculated != PACKET_CRC(Payload.bufferPLD, BlockSize))
+                    {
+                        retVal = eFunction_Error;
+                    }
+                }
+                if(retVal == eFunction_Ok)
+                {
+                    eFlashError = PayloadCommit(Payload.bufferPLD);
                     if(eFlash_OK == eFlashError)
                     {
                         Command.returnValue = eRES_OK;
@@ -134,16 +402,17 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
                 {                    
                     Command.returnValue = eRES_Error;
                 }
-                Payload.packet.u16SeqCnt = 0xFFFFU;
-                Payload.packet.u16CRC = 0xFFFFU;
+                PACKET_SEQCNT(Payload.bufferPLD, BlockSize) = 0xFFFFU;
+                PACKET_CRC(Payload.bufferPLD, BlockSize) = 0xFFFFU;
                 crcCalculated = 0x0000U;
                 pBSP->pReset();
                 pBSP->pSend(Command.bufferCMD, 2);
+                pBSP->pReady(1U);
             }
             else
             {
                 timeout++;
-                if(timeout > 0xFFU)
+                if(timeout > PROTOCOL_RECV_POLLS(BlockSize))
                 {
                     timeout = 0;
                     pBSP->pReset();
@@ -151,6 +420,134 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
             }
             break;
 
+#if defined(SELECT_WINDOW)
+        case ePayloadReceiveWindow:
+            retVal = pBSP->pRecv(Payload.bufferPLD, BlockSize + PACKET_OVERHEAD);
+            stateNext = ePayloadReceiveWindow;
+            if(retVal == eFunction_Ok)
+            {
+                timeout = 0U;
+                pBSP->pReady(0U);
+                Response.Response.u16Response = eRES_OK;
+                ePacketStatus = PacketProcess(Payload.bufferPLD);
+                if(ePacketStatus != ePACKET_Ok)
+                {
+                    Response.Response.u16Response = eRES_Error;
+                }
+                /** Write all packets which are now in sequence, the window slides with each one */
+                for(uint8_t *pPacket = PacketNext(); pPacket != NULL; pPacket = PacketNext())
+                {
+                    eFlashError = PayloadCommit(pPacket);
+                    if((eFlash_OK != eFlashError) && (eFlash_LastAddress != eFlashError))
+                    {
+                        Response.Response.u16Response = eRES_Error;
+                        break;
+                    }
+                    PacketRelease();
+                    if(eFlash_LastAddress == eFlashError)
+                    {
+                        stateNext = eFinishUpdate;
+                        break;
+                    }
+                }
+                /** A packet is buffered behind a gap, request the missing one */
+                if((stateNext != eFinishUpdate) && ((PACKET_SEQCNT(Payload.bufferPLD, BlockSize) & ~PACKET_FILL_FLAG) > PacketExpected()))
+                {
+                    Response.Response.u16Response = eRES_Error;
+                }
+                Response.Response.u16Param = PacketExpected();
+                PACKET_SEQCNT(Payload.bufferPLD, BlockSize) = 0xFFFFU;
+                PACKET_CRC(Payload.bufferPLD, BlockSize) = 0xFFFFU;
+                /** Following packets are already on the way, only a corrupted packet means
+                 *  that the frames are out of step and the received bytes are dropped */
+                if(ePacketStatus == ePACKET_CRCError)
+                {
+                    pBSP->pReset();
+                }
+                pBSP->pSend(Response.bufferRES, sizeof(tResUnion));
+                pBSP->pReady(1U);
+            }
+            else
+            {
+                timeout++;
+                if(timeout > PROTOCOL_RECV_POLLS(BlockSize))
+                {
+                    timeout = 0;
+                    pBSP->pReset();
+                }
+            }
+            break;
+#endif
+
+#if defined(SELECT_MULTICAST)
+        case ePayloadMulticast:
+            stateNext = ePayloadMulticast;
+            if(pBSP->pRecvChecked(PacketSlot(MulticastSlot), BlockSize + PACKET_OVERHEAD) == eFunction_Ok)
+            {
+                uint8_t *pPacket = PacketSlot(MulticastSlot);
+
+                /** The interface fills the other slot while this block is written, the stream is not paced */
+                MulticastSlot ^= 1U;
+                (void)pBSP->pRecvChecked(PacketSlot(MulticastSlot), BlockSize + PACKET_OVERHEAD);
+                /** Blocks are written in the order they arrive, a block which is sent again is skipped */
+                blockNo = PACKET_SEQCNT(pPacket, BlockSize);
+                if((blockNo < (((uint32_t)FlashAppPages() * BSP_FLASH_PAGE_SIZE_BYTES) / BlockSize)) &&
+                   ((BlockWritten[blockNo >> 5U] & (1UL << (blockNo & 31U))) == 0UL))
+                {
+                    pBSP->pReady(0U);
+                    eFlashError = FlashWrite(pPacket, BlockSize, blockNo);
+                    if((eFlash_OK == eFlashError) || (eFlash_LastAddress == eFlashError))
+                    {
+                        BlockWritten[blockNo >> 5U] |= (1UL << (blockNo & 31U));
+                    }
+                    pBSP->pReady(1U);
+                }
+            }
+            else if(pBSP->pRecv(Command.bufferCMD, 2) == eFunction_Ok)
+            {
+                /** Each node is asked for its missing blocks by its own ID */
+                if(Command.receivedvalue == eCMD_MissingBlocks)
+                {
+                    stateNext = eMissingBlocks;
+                }
+                else if(Command.receivedvalue == eCMD_Finish)
+                {
+                    stateNext = eFlashVerifyApplication;
+                }
+            }
+            break;
+
+        case eMissingBlocks:
+            if(pBSP->pRecv(Missing.bufferMIS, sizeof(tBLOCK_RANGE)) == eFunction_Ok)
+            {
+                stateNext = ePayloadMulticast;
+                blockNo = Missing.Range.u16First;
+                blockEnd = blockNo + Missing.Range.u16Count;
+                Missing.Missing.u16Response = eRES_OK;
+                Missing.Missing.u16Count = 0U;
+                Missing.Missing.u16Block[0] = 0xFFFFU;
+                Missing.Missing.u16Block[1] = 0xFFFFU;
+                if(blockEnd > (((uint32_t)FlashAppPages() * BSP_FLASH_PAGE_SIZE_BYTES) / BlockSize))
+                {
+                    Missing.Missing.u16Response = eRES_Error;
+                    blockEnd = blockNo;
+                }
+                for(; blockNo < blockEnd; blockNo++)
+                {
+                    if((BlockWritten[blockNo >> 5U] & (1UL << (blockNo & 31U))) == 0UL)
+                    {
+                        if(Missing.Missing.u16Count < 2U)
+                        {
+                            Missing.Missing.u16Block[Missing.Missing.u16Count] = (uint16_t)blockNo;
+                        }
+                        Missing.Missing.u16Count++;
+                    }
+                }
+                pBSP->pSend(Missing.bufferMIS, sizeof(tMISSING_BLOCKS));
+            }
+            break;
+#endif
+
         case eFinishUpdate:
             retVal = pBSP->pRecv(Command.bufferCMD, 2);
             if((retVal == eFunction_Ok) && (Command.receivedvalue == eCMD_Finish))
@@ -160,6 +557,7 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
             break;
 
         case eFlashVerifyApplication:
+            pBSP->pReady(0U);
             Command.returnValue = eRES_Abort;
             eFlashError = FlashVerifyFirmware();
             if(eFlash_OK == eFlashError)
@@ -172,6 +570,7 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
                 stateNext = eDefaultState;
             }
             pBSP->pSend(Command.bufferCMD, 2);
+            pBSP->pReady(1U);
             break;
 
         case eStartAppCMD:
@@ -180,21 +579,7 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
             do{
             }while(tickCounter--);
 
-            /* Lock flash from further write */
-            FlashLock();
-            /* Remap Application Vectors */
-            for(int i = 0; i < BSP_APP_VECTOR_SIZE_WORDS; i++)
-            {
-                AppVectorsInRAM[i] = AppVectorsInFlash[i];
-            }
-            /* Setup controller mode to consider vectors from RAM */
-            RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN;
-            SYSCFG->CFGR1 |= SYSCFG_CFGR1_MEM_MODE;
-
-            /* Setup Application Stack Pointer */
-            __set_MSP(*AppVectorsInFlash);
-            /* Setup Program counter with the start of Application */
-            ((void (*)(void))*(AppVectorsInFlash + 1UL))();
+            AppJump(pBSP);
             break;
 
         default:
@@ -226,3 +611,157 @@ eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *pBSP)
 
     return(retVal);
 }
+
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN ProtocolAppStart(const tBSPStruct *pBSP)
+* @brief     Start the application without the protocol, used if the interface
+*            of the BSP could not be initialized.
+*
+* @param[in] pBSP pointer to the BSP structure
+* @returns   eFunction_Error if there is no valid application, otherwise it
+*            does not return.
+*
+*******************************************************************************/
+eFUNCTION_RETURN ProtocolAppStart(const tBSPStruct *pBSP)
+{
+    if(FlashVerifyFirmware() != eFlash_OK)
+    {
+        return eFunction_Error;
+    }
+    AppJump(pBSP);
+
+    return eFunction_Ok;
+}
+
+/******************************************************************************/
+/**
+* eFlashError_t PayloadCommit(const uint8_t *pPacket)
+* @brief Write the data of a packet, which is next in sequence, to flash
+*        according to the transfer mode of the session.
+*
+* @param[in] pPacket pointer to the packet
+* @returns   eFlash_OK if successful
+*            or
+*            eFlash_LastAddress if the last address of program flash is written
+*            or
+*            error otherwise.
+*
+*******************************************************************************/
+static eFlashError_t PayloadCommit(const uint8_t *pPacket)
+{
+    eFlashError_t eFlashError;
+    uint16_t seqCnt = PACKET_SEQCNT(pPacket, BlockSize);
+
+    /** Fill packets declare a range of blocks with a constant or a range of blocks which is kept,
+     *  only raw images have block addresses */
+    if((seqCnt & PACKET_FILL_FLAG) != 0U)
+    {
+        if(TransferMode != eTransferRaw)
+        {
+            return eFlash_AddressError;
+        }
+        if(PACKET_FILL_IS_KEEP(pPacket))
+        {
+            return FlashKeep(seqCnt & ~PACKET_FILL_FLAG, PACKET_FILL_COUNT(pPacket), BlockSize);
+        }
+        return FlashFill(seqCnt & ~PACKET_FILL_FLAG, PACKET_FILL_COUNT(pPacket), BlockSize, PACKET_FILL_PATTERN(pPacket));
+    }
+
+    switch(TransferMode)
+    {
+#if defined(SELECT_LZ)
+        case eTransferCompressed:
+            eFlashError = LzDecode(pPacket, BlockSize);
+            break;
+#endif
+
+#if defined(SELECT_DELTA)
+        case eTransferDelta:
+            eFlashError = DeltaApply(pPacket, BlockSize);
+            break;
+#endif
+
+        case eTransferRaw:
+        default:
+            eFlashError = FlashWrite((uint8_t *)pPacket, BlockSize, seqCnt);
+            break;
+    }
+    return eFlashError;
+}
+
+/******************************************************************************/
+/**
+* void SendStatus(const tBSPStruct *pBSP)
+* @brief Reply the settings of the session to eCMD_Status.
+*
+* @param[in] pBSP pointer to the BSP structure
+*
+*******************************************************************************/
+static void SendStatus(const tBSPStruct *pBSP)
+{
+    Status.Status.u16Response = eRES_OK;
+    Status.Status.u16VerifyPolicy = (uint16_t)FlashVerifyPolicyGet();
+    Status.Status.u16BlockSize = BlockSize;
+    Status.Status.u16WindowSize = WindowLimit(pBSP);
+    Status.Status.u32VerifyCycles = FlashVerifyCycles();
+    pBSP->pSend(Status.bufferSTS, sizeof(tSESSION_STATUS));
+}
+
+/******************************************************************************/
+/**
+* uint16_t WindowLimit(const tBSPStruct *pBSP)
+* @brief Packets which may be in flight with the block size of the session.
+*        They wait in the receive buffer of the interface while flash is
+*        written, so no more than fit into it are granted. A single packet is
+*        always granted, the next one is only sent after its response.
+*
+* @param[in] pBSP pointer to the BSP structure
+* @returns   number of packets
+*
+*******************************************************************************/
+static uint16_t WindowLimit(const tBSPStruct *pBSP)
+{
+    uint16_t window = pBSP->RxBufferSize / (BlockSize + PACKET_OVERHEAD);
+
+    if(window > pBSP->WindowSize)
+    {
+        window = pBSP->WindowSize;
+    }
+    return (window == 0U) ? 1U : window;
+}
+
+/******************************************************************************/
+/**
+* void AppJump(const tBSPStruct *pBSP)
+* @brief Lock the flash, take the vectors of the application and jump to it.
+*
+* @param[in] pBSP pointer to the BSP structure
+*
+*******************************************************************************/
+static void AppJump(const tBSPStruct *pBSP)
+{
+    /* Lock flash from further write */
+    FlashLock();
+    /* The application finds the ready/busy pin as after reset */
+    pBSP->pReady(BSP_READY_RELEASE);
+    /* No bootloader interrupt may be taken once the vectors of the application are in place */
+    __disable_irq();
+    NVIC->ICER[0] = 0xFFFFFFFFUL;
+    NVIC->ICPR[0] = 0xFFFFFFFFUL;
+    /* Remap Application Vectors */
+    for(int i = 0; i < BSP_APP_VECTOR_SIZE_WORDS; i++)
+    {
+        AppVectorsInRAM[i] = AppVectorsInFlash[i];
+    }
+    /* Setup controller mode to consider vectors from RAM */
+    RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN;
+    SYSCFG->CFGR1 |= SYSCFG_CFGR1_MEM_MODE;
+
+    __enable_irq();
+
+    /* Setup Application Stack Pointer */
+    __set_MSP(*AppVectorsInFlash);
+    /* Setup Program counter with the start of Application */
+    ((void (*)(void))*(AppVectorsInFlash + 1UL))();
+}
@@ -24,21 +24,60 @@ typedef union myCmd{
     eCOMMAND_ID     receivedvalue;
 }tCmdUnion;
 
+typedef union myResponse{
+    tRESPONSE_PARAM Response;
+    uint8_t         bufferRES[4];
+}tResUnion;
+
+typedef union myDigest{
+    tDIGEST_LIST    List;
+    uint8_t         bufferDGST[sizeof(tDIGEST_LIST)];
+}tDigestUnion;
+
+typedef union myPageMask{
+    tPAGE_MASK      Mask;
+    uint8_t         bufferMSK[sizeof(tPAGE_MASK)];
+}tMaskUnion;
+
 typedef union myPayload{
     tDATA_PACKET    packet;
-    uint8_t         bufferPLD[68];
+    uint8_t         bufferPLD[BLOCK_SIZE_MAX + PACKET_OVERHEAD];
 }tPldUnion;
 
+typedef union myMissing{
+    tBLOCK_RANGE    Range;
+    tMISSING_BLOCKS Missing;
+    uint8_t         bufferMIS[sizeof(tMISSING_BLOCKS)];
+}tMissingUnion;
+
+typedef union myStatus{
+    tSESSION_STATUS Status;
+    uint8_t         bufferSTS[sizeof(tSESSION_STATUS)];
+}tStatusUnion;
+
 typedef union myAppData{
     tFIRMWARE_PARAM Firmware;
     uint8_t         bufferData[4];
 }tAppDataUnion;
 
+typedef enum {
+    eTransferRaw = 0,   /**< Packet data is written to the block given by its sequence count */
+    eTransferCompressed,/**< Packet data is decompressed into consecutive blocks              */
+    eTransferDelta      /**< Packet data is a patch against the firmware in flash             */
+}tTransferMode;
+
 typedef enum {
     eDefaultState = 0,
     eFlashEraseCMD,
+    eEraseImage,
+    eReceiveDigest,
     eWriteMemory,
+    eSetBlockSize,
+    eSetVerifyPolicy,
     ePayloadReceive,
+    ePayloadReceiveWindow,
+    ePayloadMulticast,
+    eMissingBlocks,
     ePayloadCheck,
     eWriteAppCRC,
     eFinishUpdate,
@@ -49,5 +88,6 @@ typedef enum {
 /* ***** External parameter / constant declarations ( extern const ) **********/
 /* ********************** Global func/proc prototypes *************************/
 eFUNCTION_RETURN ProtocolSM_Run(const tBSPStruct *);
+eFUNCTION_RETURN ProtocolAppStart(const tBSPStruct *);
 
 #endif
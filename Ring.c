@@ -0,0 +1,174 @@
+/******************************************************************************/
+/**
+* @file Ring.c
+* @brief Receive ring buffer filled by an interrupt and emptied by the protocol
+*
+*******************************************************************************/
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Ring.h"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+/* ********************* Type definitions ( typedef ) *************************/
+/* *********************** Global data definitions ****************************/
+/* **************** Global constant definitions ( const ) *********************/
+/* ***************** Modul global data segment ( static ) *********************/
+/* *************** Modul global constants ( static const ) ********************/
+/* **************** Local func/proc prototypes ( static ) *********************/
+/******************************************************************************/
+/**
+* void RingInit(tRing *pRing, uint8_t *pBuffer, const uint16_t size)
+* @brief Assign the storage to a ring buffer and empty it.
+*
+* @param[in] pRing pointer to the ring buffer
+* @param[in] pBuffer storage of the ring buffer
+* @param[in] size number of bytes of the storage, power of two
+*
+*******************************************************************************/
+void RingInit(tRing *pRing, uint8_t *pBuffer, const uint16_t size)
+{
+    pRing->pBuffer = pBuffer;
+    pRing->Mask = size - 1U;
+    pRing->Head = 0U;
+    pRing->Tail = 0U;
+    pRing->Index = 0U;
+    pRing->Halves = 0U;
+}
+
+/******************************************************************************/
+/**
+* void RingPut(tRing *pRing, const uint8_t data)
+* @brief Store a received byte, only called by the receive interrupt. The byte
+*        is dropped if the ring buffer is full, the packet CRC reports the loss.
+*
+* @param[in] pRing pointer to the ring buffer
+* @param[in] data received byte
+*
+*******************************************************************************/
+BSP_RAMFUNC void RingPut(tRing *pRing, const uint8_t data)
+{
+    uint16_t head = pRing->Head;
+
+    if((uint16_t)(head - pRing->Tail) <= pRing->Mask)
+    {
+        pRing->pBuffer[head & pRing->Mask] = data;
+        pRing->Head = head + 1U;
+    }
+}
+
+/******************************************************************************/
+/**
+* void RingHalf(tRing *pRing)
+* @brief Count one half of the storage filled by a circular DMA, called by the
+*        half transfer and the transfer complete interrupt of the DMA.
+*
+* @param[in] pRing pointer to the ring buffer
+*
+*******************************************************************************/
+BSP_RAMFUNC void RingHalf(tRing *pRing)
+{
+    pRing->Halves++;
+}
+
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN RingSync(tRing *pRing, const volatile uint32_t *pRemaining)
+* @brief Advance Head to the number of bytes a circular DMA has written into
+*        the storage instead of the interrupt. Called by the protocol before
+*        reading. The count of halves may miss the half which the DMA has just
+*        completed, the position in the storage tells. If the DMA has written
+*        over bytes which were not read, they are dropped with the frame.
+*
+* @param[in] pRing pointer to the ring buffer
+* @param[in] pRemaining transfer counter of the DMA, counts down from the size
+*            of the storage
+* @returns   eFunction_Ok if no byte was overwritten
+*            or
+*            eFunction_Error if the DMA has overrun the protocol.
+*
+*******************************************************************************/
+eFUNCTION_RETURN RingSync(tRing *pRing, const volatile uint32_t *pRemaining)
+{
+    const uint16_t size = pRing->Mask + 1U;
+    const uint16_t half = size >> 1;
+    /** The count is read before the position, a half completed in between is in the position */
+    const uint16_t halves = pRing->Halves;
+    const uint16_t position = size - (uint16_t)*pRemaining;
+    uint16_t head;
+
+    head = (uint16_t)(halves * half) + ((uint16_t)(position - ((halves & 1U) * half)) & pRing->Mask);
+    pRing->Head = head;
+    if((uint16_t)(head - pRing->Tail) > size)
+    {
+        pRing->Tail = head;
+        pRing->Index = 0U;
+        return eFunction_Error;
+    }
+    return eFunction_Ok;
+}
+
+/******************************************************************************/
+/**
+* uint16_t RingCount(const tRing *pRing)
+* @brief Number of bytes which are received but not yet read.
+*
+* @param[in] pRing pointer to the ring buffer
+* @returns   number of bytes in the ring buffer
+*
+*******************************************************************************/
+BSP_RAMFUNC uint16_t RingCount(const tRing *pRing)
+{
+    return (uint16_t)(pRing->Head - pRing->Tail);
+}
+
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN RingRead(tRing *pRing, uint8_t *pData, const uint16_t size)
+* @brief Take all received bytes of a frame out of the ring buffer. A frame may
+*        be larger than the ring buffer, it is collected over several calls.
+*
+* @param[in]  pRing pointer to the ring buffer
+* @param[out] pData pointer to the frame
+* @param[in]  size number of bytes of the frame
+* @returns    eFunction_Ok if the frame is complete
+*             or
+*             eFunction_Timeout if more bytes are expected.
+*
+*******************************************************************************/
+eFUNCTION_RETURN RingRead(tRing *pRing, uint8_t *pData, const uint16_t size)
+{
+    uint16_t tail = pRing->Tail;
+    uint16_t head = pRing->Head;
+
+    while((tail != head) && (pRing->Index < size))
+    {
+        pData[pRing->Index++] = pRing->pBuffer[tail & pRing->Mask];
+        tail++;
+    }
+    pRing->Tail = tail;
+    if(pRing->Index < size)
+    {
+        return eFunction_Timeout;
+    }
+    pRing->Index = 0U;
+
+    return eFunction_Ok;
+}
+
+/******************************************************************************/
+/**
+* void RingFlush(tRing *pRing)
+* @brief Drop all bytes which are received but not yet read and the part of
+*        the current frame which is already taken.
+*
+* @param[in] pRing pointer to the ring buffer
+*
+*******************************************************************************/
+void RingFlush(tRing *pRing)
+{
+    pRing->Tail = pRing->Head;
+    pRing->Index = 0U;
+}
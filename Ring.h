@@ -0,0 +1,48 @@
+/******************************************************************************/
+/**
+* @file Ring.h
+* @brief Receive ring buffer filled by an interrupt and emptied by the protocol
+*
+*******************************************************************************/
+#ifndef RING_H
+#define RING_H
+
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+
+#include "BSP.h"
+#include "Common.h"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+/* ********************* Type definitions ( typedef ) *************************/
+/**
+* @struct tRing
+* @brief Single producer single consumer ring buffer. Head is only written by
+*        the interrupt, or by RingSync() if a DMA fills the storage, Tail only
+*        by the protocol, so no locking is needed. A DMA counts its half
+*        transfers with RingHalf(), so a lap over unread bytes is detected.
+*/
+typedef struct {
+    uint8_t             *pBuffer;   /**< Storage, size is a power of two    */
+    uint16_t            Mask;       /**< Size of the storage minus one      */
+    volatile uint16_t   Head;       /**< Free running count of bytes put    */
+    volatile uint16_t   Tail;       /**< Free running count of bytes taken  */
+    uint16_t            Index;      /**< Bytes of the current frame taken   */
+    volatile uint16_t   Halves;     /**< Free running count of DMA halves   */
+}tRing;
+
+/* ***************** Global data declarations ( extern ) **********************/
+/* ***** External parameter / constant declarations ( extern const ) **********/
+/* ********************** Global func/proc prototypes *************************/
+void RingInit(tRing *pRing, uint8_t *pBuffer, const uint16_t size);
+BSP_RAMFUNC void RingPut(tRing *pRing, const uint8_t data);
+BSP_RAMFUNC void RingHalf(tRing *pRing);
+eFUNCTION_RETURN RingSync(tRing *pRing, const volatile uint32_t *pRemaining);
+BSP_RAMFUNC uint16_t RingCount(const tRing *pRing);
+eFUNCTION_RETURN RingRead(tRing *pRing, uint8_t *pData, const uint16_t size);
+void RingFlush(tRing *pRing);
+
+#endif
+
+/* end of Ring.h */
@@ -8,25 +8,48 @@
 /* ***************** Header / include files ( #include ) **********************/
 #include "Spi.h"
 #include "Gpio.h"
+#include "Ring.h"
 //#include "Timeout.h"
 #if defined (SELECT_WATCHDOG)
 /* *************** Constant / macro definitions ( #define ) *******************/
+/** DMA channels of SPI1 without remapping */
+#define SPI1_RX_DMA                 (DMA1_Channel2)
+#define SPI1_TX_DMA                 (DMA1_Channel3)
+/** Largest response which is queued for DMA transmit, all responses fit */
+#define SPI_TX_BUFFER_SIZE          (16U)
+/** Generator polynomial of the hardware CRC, the same as of CRCCalc16 */
+#define SPI_CRC_POLYNOMIAL          (0xAA55U)
+/** Number of 8 bit frames of the 16 bit hardware CRC */
+#define SPI_CRC_FRAMES              (2U)
+/** 8 bit frames the transmit FIFO holds */
+#define SPI_TX_FIFO_FRAMES          (4U)
 /* ********************* Type definitions ( typedef ) *************************/
+typedef enum {
+    eSpiRing = 0,       /**< Circular DMA into the ring buffer                   */
+    eSpiCheckedIdle,    /**< Hardware CRC, no packet reception started            */
+    eSpiCheckedBusy     /**< Hardware CRC, DMA receives the data of a packet      */
+}tSpiMode;
 /* *********************** Global data definitions ****************************/
 /* **************** Global constant definitions ( const ) *********************/
 /* ***************** Modul global data segment ( static ) *********************/
-static uint16_t index = 0U;
+static tRing    RxRing;
+static uint8_t  RxBuffer[BSP_RX_RING_SIZE];
+static uint8_t  TxBuffer[SPI_TX_BUFFER_SIZE];
+static tSpiMode Mode = eSpiRing;
+static uint16_t CRCIndex = 0U;
 /* *************** Modul global constants ( static const ) ********************/
 /* **************** Local func/proc prototypes ( static ) *********************/
+static void SpiRingStart(void);
 /******************************************************************************/
 /**
-* void SpiInit(tBSPType)
+* eFUNCTION_RETURN SpiInit(tBSPType)
 * @brief Configure SPI1 (STM32F031:PA4(NSS),PA7(MOSI),PA6(MISO),PA5(SCK)) and
 *        initialze variables.
 * @param[in] tBSPType The type of target to be configured according to BSP
+* @returns eFunction_Ok, the configuration can not fail
 *
 *******************************************************************************/
-void SpiInit(tBSPType BSPType)
+eFUNCTION_RETURN SpiInit(tBSPType BSPType)
 {
     RCC->AHBENR |= RCC_AHBENR_GPIOBEN | RCC_AHBENR_GPIOBEN;
 
@@ -95,103 +118,232 @@ void SpiInit(tBSPType BSPType)
     /*! SPI Slave event is generated if the FIFO level is greater than or equal to 1/4 (8-bit)
      *  SPI has 8 bit data word length 
      */
-    SPI1->CR2 = SPI_CR2_FRXTH |
+    SPI1->CR2 = SPI_CR2_FRXTH | SPI_CR2_RXDMAEN |
 								SPI_CR2_DS_2 | SPI_CR2_DS_1 | SPI_CR2_DS_0; 
+    /*! Received bytes are stored circularly in the ring buffer by DMA, the master
+     *  may clock the packets without gaps between the bytes */
+    RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+    SPI1_RX_DMA->CPAR  = (uint32_t)&(SPI1->DR);
+    SPI1->CRCPR = SPI_CRC_POLYNOMIAL;
+    /*! Responses are queued by DMA in SpiSend */
+    SPI1_TX_DMA->CCR   = 0UL;
+    SPI1_TX_DMA->CPAR  = (uint32_t)&(SPI1->DR);
+    SPI1->CR2 |= SPI_CR2_TXDMAEN;
     /*! SPI peripheral is set in slave mode */ 
-    SPI1->CR1 = SPI_CR1_SPE |  /*! SPI is enabled in the hardware module */
-                SPI_CR1_CPOL;  /*! Clock polarity is set */
+    SPI1->CR1 = SPI_CR1_CPOL;  /*! Clock polarity is set */
+    NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+    /*! SPI is enabled in the hardware module */
+    SpiRingStart();
+
+    return eFunction_Ok;
 }
 
 /******************************************************************************/
 /**
 * void SpiSend(uint8_t *pTxData, uint16_t size)
-* @brief Implement SPI1 send. 1s timeout if nothing is received for transmitting.
+* @brief Implement SPI1 send. The response is copied and queued for DMA, it is
+*        shifted out while the master clocks in the next packet. The DMA of a
+*        response which is not yet clocked out is restarted with the new one,
+*        the bytes already in the transmit FIFO are still sent before it.
+*        With the hardware CRC the transmit DMA would start the CRC phase at
+*        the end of its count, so the response goes into the transmit FIFO
+*        without DMA and is limited to its size.
 *
 * @param[in] pTxData pointer to the data to be transmitted
 * @param[in] size number of bytes
-* @returns   eFunction_Ok if successful
-*            or
-*            eFunction_Timeout if an timeout error occurs.
 *
 *******************************************************************************/
 void SpiSend(uint8_t *pTxData, uint16_t size)
 {
-    volatile uint16_t tmp;
-    uint16_t i = 0;
-    while (i < size)
-		{
-				while((SPI1->SR & SPI_SR_TXE) != SPI_SR_TXE);
-				*(volatile uint8_t *)&(SPI1->DR) = pTxData[i++];
-				if(SPI1->SR & SPI_SR_OVR)
-				{
-						tmp = SPI1->DR;
-						tmp = SPI1->SR;
-						(void)tmp;
-				}
-		}
+    if(size > SPI_TX_BUFFER_SIZE)
+    {
+        size = SPI_TX_BUFFER_SIZE;
+    }
+    SPI1_TX_DMA->CCR = 0UL;
+    if(Mode != eSpiRing)
+    {
+        for(uint16_t i = 0U; (i < size) && (i < SPI_TX_FIFO_FRAMES); i++)
+        {
+            *(volatile uint8_t *)&(SPI1->DR) = pTxData[i];
+        }
+        return;
+    }
+    for(uint16_t i = 0U; i < size; i++)
+    {
+        TxBuffer[i] = pTxData[i];
+    }
+    SPI1_TX_DMA->CMAR  = (uint32_t)TxBuffer;
+    SPI1_TX_DMA->CNDTR = size;
+    SPI1_TX_DMA->CCR   = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_PL_0 | DMA_CCR_EN;
 }
 
 /******************************************************************************/
 /**
 * eFUNCTION_RETURN SpiRecv(uint8_t *pRxData, uint16_t size)
 *
-* @brief Read from SPI1.
+* @brief Read from SPI1, takes all bytes stored by the DMA.
 *
 * @param[out] pRxData pointer to 68 bytes data
 * @param[in]  size number of bytes
 * @returns    eFunction_Ok if successful
 *             or
-*             eFunction_Error if timeout error occurs.
+*             eFunction_Error if the DMA has overwritten bytes which were not read
+*             or
+*             eFunction_Timeout if more bytes are expected.
 *
 *******************************************************************************/
 eFUNCTION_RETURN SpiRecv(uint8_t *pRxData, uint16_t size)
+{
+    if(Mode != eSpiRing)
+    {
+        SpiRingStart();
+    }
+    if(RingSync(&RxRing, &(SPI1_RX_DMA->CNDTR)) != eFunction_Ok)
+    {
+        return eFunction_Error;
+    }
+    return RingRead(&RxRing, pRxData, size);
+}
+
+/******************************************************************************/
+/**
+* void SpiReset(void)
+*
+* @brief Reset receive pointer index and drop received bytes
+*
+* @returns    none
+*
+*******************************************************************************/
+inline void SpiReset(void)
 {
     volatile uint16_t tmp;
-    eFUNCTION_RETURN retVal = eFunction_Timeout;
 
-    if((SPI1->SR & SPI_SR_RXNE) == SPI_SR_RXNE)
+    if(Mode == eSpiRing)
+    {
+        (void)RingSync(&RxRing, &(SPI1_RX_DMA->CNDTR));
+        RingFlush(&RxRing);
+    }else
     {
-        pRxData[index] = (uint8_t)SPI1->DR;
-        index++;
+        /*! The packet which is received at the moment is dropped */
+        Mode = eSpiCheckedIdle;
     }
+    while((SPI1->SR & SPI_SR_OVR) == SPI_SR_OVR)
+    {
+        tmp = SPI1->DR;
+        tmp = SPI1->SR;
+        (void)tmp;
+    }
+}
+
 
+/******************************************************************************/
+/**
+* eFUNCTION_RETURN SpiRecvChecked(uint8_t *pRxData, uint16_t size)
+*
+* @brief Receive a packet whose CRC is checked by the SPI1 hardware CRC unit
+*        during the transfer. The DMA stores the data frames directly in
+*        pRxData, the last two frames are the CRC. The master sends the
+*        CRC-16 with polynomial 0xAA55 and start value 0 over the data frames,
+*        most significant byte first. This equals CRCCalc16 over the data
+*        frames followed by two zero bytes.
+*
+* @param[out] pRxData pointer to the packet
+* @param[in]  size number of bytes including the CRC
+* @returns    eFunction_Ok if the packet is received without CRC error
+*             or
+*             eFunction_Error if the hardware reports a CRC error
+*             or
+*             eFunction_Timeout if the packet is not yet complete.
+*
+*******************************************************************************/
+eFUNCTION_RETURN SpiRecvChecked(uint8_t *pRxData, uint16_t size)
+{
+    uint16_t crcError;
 
-    if(index >= size)
+    if(Mode != eSpiCheckedBusy)
     {
-        index = 0;
-        retVal = eFunction_Ok;
-        while((SPI1->SR & SPI_SR_OVR) == SPI_SR_OVR)
-        {
-            tmp = SPI1->DR;
-            tmp = SPI1->SR;
-            (void)tmp;
-        }
+        /*! CRC calculation restarts when CRCEN is set while the SPI is disabled. The CRC phase
+         *  follows the count of the receive DMA only while the transmit DMA is disabled */
+        SPI1->CR1 &= ~(SPI_CR1_SPE | SPI_CR1_CRCEN);
+        SPI1_TX_DMA->CCR = 0UL;
+        SPI1->CR2 &= ~SPI_CR2_TXDMAEN;
+        SPI1_RX_DMA->CCR   = 0UL;
+        SPI1_RX_DMA->CMAR  = (uint32_t)pRxData;
+        SPI1_RX_DMA->CNDTR = size - SPI_CRC_FRAMES;
+        SPI1_RX_DMA->CCR   = DMA_CCR_MINC | DMA_CCR_PL_1 | DMA_CCR_EN;
+        SPI1->SR &= ~SPI_SR_CRCERR;
+        SPI1->CR1 |= SPI_CR1_CRCL | SPI_CR1_CRCEN;
+        SPI1->CR1 |= SPI_CR1_SPE;
+        Mode = eSpiCheckedBusy;
+        CRCIndex = 0U;
+        return eFunction_Timeout;
+    }
+    if(SPI1_RX_DMA->CNDTR != 0U)
+    {
+        return eFunction_Timeout;
+    }
+    /*! The CRC frames follow the data in the receive FIFO */
+    while((CRCIndex < SPI_CRC_FRAMES) && ((SPI1->SR & SPI_SR_RXNE) == SPI_SR_RXNE))
+    {
+        pRxData[size - SPI_CRC_FRAMES + CRCIndex] = *(volatile uint8_t *)&(SPI1->DR);
+        CRCIndex++;
+    }
+    if(CRCIndex < SPI_CRC_FRAMES)
+    {
+        return eFunction_Timeout;
     }
+    crcError = SPI1->SR & SPI_SR_CRCERR;
+    SPI1->SR &= ~SPI_SR_CRCERR;
+    Mode = eSpiCheckedIdle;
 
-    return retVal;
+    return (crcError != 0U) ? eFunction_Error : eFunction_Ok;
 }
 
 /******************************************************************************/
 /**
-* void SpiReset(void)
+* void SpiRingStart(void)
 *
-* @brief Reset receive pointer index
-*
-* @returns    none
+* @brief Disable the hardware CRC and restart the circular DMA into the empty
+*        ring buffer.
 *
 *******************************************************************************/
-inline void SpiReset(void)
+static void SpiRingStart(void)
 {
-    index = 0;
-		volatile uint16_t tmp;
-		while((SPI1->SR & SPI_SR_OVR) == SPI_SR_OVR)
-		{
-				tmp = SPI1->DR;
-				tmp = SPI1->SR;
-				(void)tmp;
-		}
+    SPI1->CR1 &= ~(SPI_CR1_SPE | SPI_CR1_CRCEN | SPI_CR1_CRCL);
+    SPI1->CR2 |= SPI_CR2_TXDMAEN;
+    RingInit(&RxRing, RxBuffer, BSP_RX_RING_SIZE);
+    SPI1_RX_DMA->CCR   = 0UL;
+    SPI1_RX_DMA->CMAR  = (uint32_t)RxBuffer;
+    SPI1_RX_DMA->CNDTR = BSP_RX_RING_SIZE;
+    /*! Each half is counted by the interrupt, so a lap over unread bytes is detected */
+    DMA1->IFCR = DMA_IFCR_CHTIF2 | DMA_IFCR_CTCIF2;
+    SPI1_RX_DMA->CCR   = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_PL_1 | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+    SPI1->CR1 |= SPI_CR1_SPE;
+    Mode = eSpiRing;
 }
 
+/******************************************************************************/
+/**
+* void DMA1_Channel2_3_IRQHandler(void)
+*
+* @brief Half transfer and transfer complete interrupt of the receive DMA,
+*        runs from SRAM to count the halves while flash is busy. The DMA of a
+*        packet with hardware CRC does not request the interrupt.
+*
+*******************************************************************************/
+BSP_RAMFUNC void DMA1_Channel2_3_IRQHandler(void)
+{
+    if((DMA1->ISR & DMA_ISR_HTIF2) != 0UL)
+    {
+        DMA1->IFCR = DMA_IFCR_CHTIF2;
+        RingHalf(&RxRing);
+    }
+    if((DMA1->ISR & DMA_ISR_TCIF2) != 0UL)
+    {
+        DMA1->IFCR = DMA_IFCR_CTCIF2;
+        RingHalf(&RxRing);
+    }
+}
 
 #endif // defined SELECT_WATCHDOG
 
@@ -21,10 +21,12 @@
 /* ***************** Global data declarations ( extern ) **********************/
 /* ***** External parameter / constant declarations ( extern const ) **********/
 /* ********************** Global func/proc prototypes *************************/
-void SpiInit(tBSPType BSPType);
+eFUNCTION_RETURN SpiInit(tBSPType BSPType);
 void SpiSend(uint8_t *pTxData, uint16_t size);
 void SpiReset(void);
 eFUNCTION_RETURN SpiRecv(uint8_t *pRxData, uint16_t size);
+eFUNCTION_RETURN SpiRecvChecked(uint8_t *pRxData, uint16_t size);
+void DMA1_Channel2_3_IRQHandler(void);
 
 #endif // SPI_H_
 
@@ -10,17 +10,22 @@
 #include <stddef.h>
 
 #include "Gpio.h"
+#include "Ring.h"
 
 #include "Usart1.h"
 
 #if defined(SELECT_TORQUE) || defined(SELECT_PILOT)
 
 /* *************** Constant / macro definitions ( #define ) *******************/
+/** DMA channel of USART1_RX without remapping */
+#define USART1_RX_DMA               (DMA1_Channel3)
 /* ********************* Type definitions ( typedef ) *************************/
 /* *********************** Global data definitions ****************************/
 /* **************** Global constant definitions ( const ) *********************/
 /* ***************** Modul global data segment ( static ) *********************/
-static uint16_t index = 0U;
+static tRing    RxRing;
+static uint8_t  RxBuffer[BSP_RX_RING_SIZE];
+static uint8_t  RxDMA = 0U;
 static uint32_t TxPin = 0UL;
 static uint32_t RxPin = 0UL;
 static uint32_t Baud = 0UL;
@@ -30,14 +35,15 @@ static GPIO_TypeDef *pGPIO_USART = NULL;
 /* **************** Local func/proc prototypes ( static ) *********************/
 /******************************************************************************/
 /**
-* void Usart1Init(tBSPType)
+* eFUNCTION_RETURN Usart1Init(tBSPType)
 * @brief Configure USART1 according to board type and initialze variables.
 *         pin values for rx and tx are specified in respective BSP macros.
 * @param[in] tBSPType The type of target to be configured according to BSP, Only serial
 *              based bsp types handled.
+* @returns eFunction_Ok, the configuration can not fail
 *
 *******************************************************************************/
-void Usart1Init(tBSPType BSPType)
+eFUNCTION_RETURN Usart1Init(tBSPType BSPType)
 {
     RCC->AHBENR |= RCC_AHBENR_GPIOAEN;
 
@@ -52,6 +58,8 @@ void Usart1Init(tBSPType BSPType)
 
         case BSP_TorqueSensor:
         default:
+            /** At 1.125 Mbaud the bytes are stored by DMA, no interrupt per byte */
+            RxDMA = 1U;
             TxPin = BSP_TORQUE_UART_TX_PIN;
             RxPin = BSP_TORQUE_UART_RX_PIN;
             Baud  = BSP_TORQUE_UART_BAUD;
@@ -85,7 +93,28 @@ void Usart1Init(tBSPType BSPType)
 
     RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
     USART1->BRR = __USART_BRR(SystemCoreClock, Baud);  
-    USART1->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;  // 8N1
+    RingInit(&RxRing, RxBuffer, BSP_RX_RING_SIZE);
+    if(RxDMA != 0U)
+    {
+        /** The two halves of the ring buffer are filled alternately by a circular DMA,
+         *  one packet is taken out while the next one is received */
+        RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+        USART1_RX_DMA->CCR   = 0UL;
+        USART1_RX_DMA->CPAR  = (uint32_t)&(USART1->RDR);
+        USART1_RX_DMA->CMAR  = (uint32_t)RxBuffer;
+        USART1_RX_DMA->CNDTR = BSP_RX_RING_SIZE;
+        /** Each half is counted by the interrupt, so a lap over unread bytes is detected */
+        USART1_RX_DMA->CCR   = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_PL_1 | DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_EN;
+        NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+        /** An overrun must not stop the DMA requests, the packet CRC reports the loss */
+        USART1->CR3 = USART_CR3_DMAR | USART_CR3_OVRDIS;
+        USART1->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;  // 8N1
+    }else
+    {
+        USART1->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE | USART_CR1_UE;  // 8N1
+        NVIC_EnableIRQ(USART1_IRQn);
+    }
+    return eFunction_Ok;
 }
 
 /******************************************************************************/
@@ -111,47 +140,84 @@ void Usart1Send(uint8_t *pTxData, const uint16_t size)
 /**
 * eFUNCTION_RETURN Usart1Recv(uint8_t *pRxData, uint16_t size)
 *
-* @brief Read from UART. 
+* @brief Read from UART, takes all bytes received by the interrupt or the DMA.
 *
 * @param[out] pRxData pointer to 68 bytes data
 * @param[in]  size number of bytes
 * @returns    eFunction_Ok if successful
 *             or
-*             eFunction_Error if data losts.
+*             eFunction_Error if the DMA has overwritten bytes which were not read
 *             or
-*             eFunction_Timeout if an timeout error occurs.
+*             eFunction_Timeout if more bytes are expected.
 *
 *******************************************************************************/
 eFUNCTION_RETURN Usart1Recv(uint8_t *pRxData, const uint16_t size)
 {
-    eFUNCTION_RETURN retVal = eFunction_Timeout;
-    
-    if(USART1->ISR & USART_ISR_RXNE)
+    if((RxDMA != 0U) && (RingSync(&RxRing, &(USART1_RX_DMA->CNDTR)) != eFunction_Ok))
     {
-        pRxData[index] = USART1->RDR;
-        index++;
+        return eFunction_Error;
     }
-    
-    if(index >= size)
-    {
-        index = 0;
-        retVal = eFunction_Ok;
-    }
-    return retVal;
+    return RingRead(&RxRing, pRxData, size);
 }
 
 /******************************************************************************/
 /**
 * void Usart1Reset(void)
 *
-* @brief Reset receive pointer index
+* @brief Reset receive pointer index and drop received bytes
 *
 * @returns    none
 *
 *******************************************************************************/
 inline void Usart1Reset(void)
 {
-    index = 0;
+    if(RxDMA != 0U)
+    {
+        (void)RingSync(&RxRing, &(USART1_RX_DMA->CNDTR));
+    }
+    RingFlush(&RxRing);
+}
+
+/******************************************************************************/
+/**
+* void USART1_IRQHandler(void)
+*
+* @brief Receive interrupt, runs from SRAM to take bytes while flash is busy.
+*        An overrun has to be cleared or the interrupt keeps pending.
+*
+*******************************************************************************/
+BSP_RAMFUNC void USART1_IRQHandler(void)
+{
+    if(USART1->ISR & USART_ISR_RXNE)
+    {
+        RingPut(&RxRing, (uint8_t)USART1->RDR);
+    }
+    if(USART1->ISR & (USART_ISR_ORE | USART_ISR_FE | USART_ISR_NE))
+    {
+        USART1->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF;
+    }
+}
+
+/******************************************************************************/
+/**
+* void DMA1_Channel2_3_IRQHandler(void)
+*
+* @brief Half transfer and transfer complete interrupt of the receive DMA,
+*        runs from SRAM to count the halves while flash is busy.
+*
+*******************************************************************************/
+BSP_RAMFUNC void DMA1_Channel2_3_IRQHandler(void)
+{
+    if((DMA1->ISR & DMA_ISR_HTIF3) != 0UL)
+    {
+        DMA1->IFCR = DMA_IFCR_CHTIF3;
+        RingHalf(&RxRing);
+    }
+    if((DMA1->ISR & DMA_ISR_TCIF3) != 0UL)
+    {
+        DMA1->IFCR = DMA_IFCR_CTCIF3;
+        RingHalf(&RxRing);
+    }
 }
 
 #endif // SELECT_TORQUE || SELECT_PILOT
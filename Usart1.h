@@ -27,10 +27,12 @@
 /* ***************** Global data declarations ( extern ) **********************/
 /* ***** External parameter / constant declarations ( extern const ) **********/
 /* ********************** Global func/proc prototypes *************************/
-void Usart1Init(tBSPType BSPType);
+eFUNCTION_RETURN Usart1Init(tBSPType BSPType);
 void Usart1Send(uint8_t *pTxData, uint16_t size);
 void Usart1Reset(void);
 eFUNCTION_RETURN Usart1Recv(uint8_t *pRxData, uint16_t size);
+void USART1_IRQHandler(void);
+void DMA1_Channel2_3_IRQHandler(void);
 
 #endif // USART1_H_
 
@@ -22,6 +22,15 @@ int main (void)
 {
     tBSPStruct* pBSP = BSP_Init();
 
+    /* No update can be received without the interface */
+    if(pBSP->InitStatus != eFunction_Ok)
+    {
+        (void)ProtocolAppStart(pBSP);
+        for(;;)
+        {
+        }
+    }
+
     for(;;)
     {
         ProtocolSM_Run(pBSP);
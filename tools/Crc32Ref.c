@@ -0,0 +1,222 @@
+/******************************************************************************/
+/**
+* @file Crc32Ref.c
+* @brief Host reference of the CRC-32 image check. Compares CRCCalc32 on the
+*        modelled CRC unit with a table CRC-32 as zlib crc32, then builds the
+*        application area of an image with the parameters of FW_PARAM_CRC32.
+*        CRC.c is built as it is with the host compiler:
+*
+*        cc -O2 -I tools/host -o Crc32Ref tools/Crc32Ref.c
+*        ./Crc32Ref [image.bin output.bin [16|32]]
+*
+*        The image starts at BSP_ABSOLUTE_APP_START and is padded with 0xFF to
+*        a multiple of four. The output covers the application area up to the
+*        end of flash of the target, 32kB if not given: the image, 0xFF up to
+*        the firmware parameters and tFIRMWARE_PARAM32 in the last 8 bytes.
+*        Returns 0 if all random cases give the same CRC and the output is
+*        written.
+*
+*******************************************************************************/
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../CRC.c"
+#include "../Flash.h"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+#define REF_CASES               (20000UL)
+#define REF_WORDS_MAX           (257U)      /** Largest packet, BLOCK_SIZE_MAX plus sequence count and CRC, in words */
+#define REF_POLY_REVERSED       (0xEDB88320UL)
+/* ********************* Type definitions ( typedef ) *************************/
+/* ***************** Modul global data segment ( static ) *********************/
+static uint32_t Buffer[BSP_FLASH_MAX_SIZE_32KB / sizeof(uint32_t)];
+static uint32_t Table[256];
+static uint32_t Seed = 1UL;
+/* **************** Local func/proc prototypes ( static ) *********************/
+static uint32_t Crc32Table(const uint8_t *data, uint32_t size, uint32_t startVal);
+static uint32_t Crc32Unit(const uint32_t *data, uint32_t words, uint32_t startVal);
+static int BuildImage(const char *pIn, const char *pOut, uint32_t flashEnd);
+static uint32_t Random(void);
+
+/******************************************************************************/
+/**
+* int main(int argc, char *argv[])
+* @brief Compare both calculations for random data, sizes and start values,
+*        each case also continues the CRC over a second part. Then build the
+*        application area if an image is given.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    unsigned long failed = 0UL;
+
+    for(uint32_t n = 0U; n < 256U; n++)
+    {
+        uint32_t crc = n;
+
+        for(uint8_t i = 0U; i < 8U; i++)
+        {
+            crc = ((crc & 1UL) != 0UL) ? ((crc >> 1) ^ REF_POLY_REVERSED) : (crc >> 1);
+        }
+        Table[n] = crc;
+    }
+
+    for(unsigned long n = 0UL; n < REF_CASES; n++)
+    {
+        uint32_t words = Random() % (REF_WORDS_MAX + 1U);
+        uint32_t split = (words != 0U) ? (Random() % words) : 0U;
+        uint32_t startVal = ((n % 2UL) == 0UL) ? 0UL : Random();
+        uint32_t crcTable, crcUnit;
+
+        for(uint32_t i = 0U; i < words; i++)
+        {
+            Buffer[i] = Random();
+        }
+        crcTable = Crc32Table((const uint8_t *)Buffer, words * sizeof(uint32_t), startVal);
+        crcUnit = Crc32Unit(&Buffer[split], words - split, Crc32Unit(Buffer, split, startVal));
+        if(crcTable != crcUnit)
+        {
+            if(failed < 10UL)
+            {
+                printf("mismatch: words %u split %u start 0x%08X\n", (unsigned)words, (unsigned)split, (unsigned)startVal);
+            }
+            failed++;
+        }
+    }
+    /** Check value of CRC-32 */
+    if(Crc32Table((const uint8_t *)"123456789", 9U, 0UL) != 0xCBF43926UL)
+    {
+        printf("check value mismatch\n");
+        failed++;
+    }
+    printf("%lu cases, %lu mismatches\n", REF_CASES, failed);
+    if(failed != 0UL)
+    {
+        return 1;
+    }
+
+    if(argc > 2)
+    {
+        uint32_t flashEnd = ((argc > 3) && (strtoul(argv[3], NULL, 0) == 16UL)) ?
+                            BSP_ABSOLUTE_FLASH_END_16KB : BSP_ABSOLUTE_FLASH_END_32KB;
+
+        return BuildImage(argv[1], argv[2], flashEnd);
+    }
+    return 0;
+}
+
+/******************************************************************************/
+/**
+* uint32_t Crc32Table(const uint8_t *data, uint32_t size, uint32_t startVal)
+* @brief CRC-32 as zlib crc32, one byte per loop with a table.
+*
+*******************************************************************************/
+static uint32_t Crc32Table(const uint8_t *data, uint32_t size, uint32_t startVal)
+{
+    uint32_t crc = startVal ^ 0xFFFFFFFFUL;
+
+    while(size > 0U)
+    {
+        crc = Table[(crc ^ *data++) & 0xFFU] ^ (crc >> 8);
+        size--;
+    }
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+/******************************************************************************/
+/**
+* uint32_t Crc32Unit(const uint32_t *data, uint32_t words, uint32_t startVal)
+* @brief CRCCalc32 on the modelled CRC unit, the model loads INIT again at the
+*        first access of the data register.
+*
+*******************************************************************************/
+static uint32_t Crc32Unit(const uint32_t *data, uint32_t words, uint32_t startVal)
+{
+    HostCRC.Accesses = 0UL;
+
+    return CRCCalc32(data, words, startVal);
+}
+
+/******************************************************************************/
+/**
+* int BuildImage(const char *pIn, const char *pOut, uint32_t flashEnd)
+* @brief Write the application area of an image with tFIRMWARE_PARAM32. The
+*        image has to end below the update journal, FlashVerifyImage refuses a
+*        longer length. The CRC is taken by CRCCalc32 and checked again with
+*        the table.
+*
+* @param[in] pIn  file of the image from BSP_ABSOLUTE_APP_START
+* @param[in] pOut file of the application area
+* @param[in] flashEnd end of flash of the target
+* @returns   0 if written
+*
+*******************************************************************************/
+static int BuildImage(const char *pIn, const char *pOut, uint32_t flashEnd)
+{
+    const uint32_t areaSize = flashEnd - BSP_ABSOLUTE_APP_START;
+    const uint32_t imageMax = areaSize - 8UL - FLASH_JOURNAL_BYTES;
+    tFIRMWARE_PARAM32 param;
+    uint8_t *pArea = (uint8_t *)Buffer;
+    uint32_t size;
+    FILE *pFile = fopen(pIn, "rb");
+
+    if(pFile == NULL)
+    {
+        printf("can not open %s\n", pIn);
+        return 1;
+    }
+    memset(pArea, 0xFF, areaSize);
+    size = (uint32_t)fread(pArea, 1U, imageMax + 1UL, pFile);
+    fclose(pFile);
+    size = (size + (uint32_t)sizeof(uint32_t) - 1U) & ~((uint32_t)sizeof(uint32_t) - 1U);
+    if((size == 0U) || (size > imageMax) || (size >= FW_PARAM_CRC32))
+    {
+        printf("image of %u bytes, at most %u bytes end below the journal\n", (unsigned)size, (unsigned)imageMax);
+        return 1;
+    }
+
+    param.u32FWCRC = Crc32Unit(Buffer, size / sizeof(uint32_t), 0UL);
+    param.u16Reserved = 0xFFFFU;
+    param.u16FWLen = (uint16_t)(size | FW_PARAM_CRC32);
+    if(param.u32FWCRC != Crc32Table(pArea, size, 0UL))
+    {
+        printf("CRC unit and table differ\n");
+        return 1;
+    }
+    memcpy(&pArea[areaSize - sizeof(param)], &param, sizeof(param));
+
+    pFile = fopen(pOut, "wb");
+    if((pFile == NULL) || (fwrite(pArea, 1U, areaSize, pFile) != areaSize))
+    {
+        printf("can not write %s\n", pOut);
+        if(pFile != NULL)
+        {
+            fclose(pFile);
+        }
+        return 1;
+    }
+    fclose(pFile);
+    printf("%u bytes, CRC-32 0x%08X, length 0x%04X at 0x%08X\n", (unsigned)size, (unsigned)param.u32FWCRC,
+           (unsigned)param.u16FWLen, (unsigned)(flashEnd - sizeof(param)));
+
+    return 0;
+}
+
+/******************************************************************************/
+/**
+* uint32_t Random(void)
+* @brief Fixed sequence of pseudo random numbers, the runs can be repeated.
+*
+*******************************************************************************/
+static uint32_t Random(void)
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+
+    return Seed;
+}
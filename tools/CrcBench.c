@@ -0,0 +1,156 @@
+/******************************************************************************/
+/**
+* @file CrcBench.c
+* @brief Host check of CRCCalc16 against the former bit-wise calculation and
+*        throughput of both. CRC.c is built as it is with the host compiler:
+*
+*        cc -O2 -I tools/host -o CrcBench tools/CrcBench.c
+*        ./CrcBench [cases]
+*
+*        Returns 0 if all random cases give the same CRC.
+*
+*******************************************************************************/
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../CRC.c"
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+#define BENCH_CASES             (200000UL)
+#define BENCH_SIZE_MAX          (1028U)     /** Largest packet, BLOCK_SIZE_MAX plus sequence count and CRC */
+#define BENCH_BYTES             (64UL * 1024UL * 1024UL)
+/* ********************* Type definitions ( typedef ) *************************/
+/* ***************** Modul global data segment ( static ) *********************/
+static uint8_t Buffer[BENCH_SIZE_MAX];
+static uint32_t Seed = 1UL;
+/* **************** Local func/proc prototypes ( static ) *********************/
+static uint16_t CRCCalc16Bitwise(const uint8_t *data, uint16_t size, uint16_t startVal);
+static uint32_t Random(void);
+static double Throughput(uint16_t (*pCalc)(const uint8_t *, uint16_t, uint16_t), uint16_t *pResult);
+
+/******************************************************************************/
+/**
+* int main(int argc, char *argv[])
+* @brief Compare both calculations for random data, sizes and start values,
+*        then time them over BENCH_BYTES in packets of the largest size.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    unsigned long cases = (argc > 1) ? strtoul(argv[1], NULL, 0) : BENCH_CASES;
+    unsigned long failed = 0UL;
+    uint16_t resultTable, resultBitwise;
+    double mbTable, mbBitwise;
+
+    for(unsigned long n = 0UL; n < cases; n++)
+    {
+        uint16_t size = (uint16_t)(Random() % (BENCH_SIZE_MAX + 1U));
+        uint16_t startVal = (uint16_t)Random();
+
+        for(uint16_t i = 0U; i < size; i++)
+        {
+            Buffer[i] = (uint8_t)Random();
+        }
+        if(CRCCalc16(Buffer, size, startVal) != CRCCalc16Bitwise(Buffer, size, startVal))
+        {
+            if(failed < 10UL)
+            {
+                printf("mismatch: size %u start 0x%04X\n", (unsigned)size, (unsigned)startVal);
+            }
+            failed++;
+        }
+    }
+    printf("%lu cases, %lu mismatches\n", cases, failed);
+
+    mbTable = Throughput(&CRCCalc16, &resultTable);
+    mbBitwise = Throughput(&CRCCalc16Bitwise, &resultBitwise);
+    printf("nibble table %8.1f MB/s\n", mbTable);
+    printf("bit-wise     %8.1f MB/s\n", mbBitwise);
+    printf("speedup      %8.1f\n", mbTable / mbBitwise);
+
+    return ((failed == 0UL) && (resultTable == resultBitwise)) ? 0 : 1;
+}
+
+/******************************************************************************/
+/**
+* uint16_t CRCCalc16Bitwise(const uint8_t *data, uint16_t size, uint16_t startVal)
+* @brief CRCCalc16 as it was before the table, one bit per loop.
+*
+*******************************************************************************/
+static uint16_t CRCCalc16Bitwise(const uint8_t *data, uint16_t size, uint16_t startVal)
+{
+    uint16_t out = startVal;
+    uint8_t bits_read = 0, bit_flag;
+    /* Sanity check */
+    if(data == NULL)
+    {
+        return 0;
+    }
+    while(size > 0)
+    {
+        bit_flag = out >> 15;
+        /* Get next bit */
+        out <<= 1;
+        out |= (*data >> (7 - bits_read)) & 1;
+        /* Increment bit counter */
+        bits_read++;
+        if(bits_read > 7)
+        {
+            bits_read = 0;
+            data++;
+            size--;
+        }
+        /* Cycle check */
+        if(bit_flag)
+        {
+            out ^= CRC16;
+        }
+    }
+    return out;
+}
+
+/******************************************************************************/
+/**
+* uint32_t Random(void)
+* @brief Fixed sequence of pseudo random numbers, the runs can be repeated.
+*
+*******************************************************************************/
+static uint32_t Random(void)
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+
+    return Seed;
+}
+
+/******************************************************************************/
+/**
+* double Throughput(uint16_t (*pCalc)(const uint8_t *, uint16_t, uint16_t), uint16_t *pResult)
+* @brief Run a calculation over BENCH_BYTES, each packet continues the CRC of
+*        the previous one so the calls can not be dropped.
+*
+* @param[in]  pCalc calculation to be timed
+* @param[out] pResult CRC over all packets
+* @returns    megabytes per second
+*
+*******************************************************************************/
+static double Throughput(uint16_t (*pCalc)(const uint8_t *, uint16_t, uint16_t), uint16_t *pResult)
+{
+    uint16_t crc = 0U;
+    clock_t start = clock();
+    double seconds;
+
+    for(unsigned long done = 0UL; done < BENCH_BYTES; done += BENCH_SIZE_MAX)
+    {
+        crc = pCalc(Buffer, BENCH_SIZE_MAX, crc);
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    *pResult = crc;
+
+    return ((double)BENCH_BYTES / (1024.0 * 1024.0)) / seconds;
+}
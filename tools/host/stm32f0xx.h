@@ -0,0 +1,107 @@
+/******************************************************************************/
+/**
+* @file stm32f0xx.h
+* @brief Host stand-in for the device header, only what CRC.c needs to build
+*        with the host compiler. The peripherals are plain variables, except
+*        the data register of the CRC unit: each access of CRC->DR first
+*        takes the word written by the access before, then presets the
+*        register with the result, so a read returns the CRC over all words
+*        written since HostCRC.Accesses was cleared. The unit is modelled with
+*        the fixed polynomial 0x04C11DB7, INIT and the REV_IN/REV_OUT bits of
+*        CR; bit reversal by byte or halfword is not modelled.
+*
+*******************************************************************************/
+#ifndef STM32F0XX_HOST_H
+#define STM32F0XX_HOST_H
+
+/* ***************** Header / include files ( #include ) **********************/
+
+#include <stdint.h>
+
+/* *************** Constant / macro definitions ( #define ) *******************/
+#define RCC_AHBENR_CRCEN        (1UL << 6)
+#define CRC_CR_RESET            (1UL << 0)
+#define CRC_CR_REV_IN           (3UL << 5)
+#define CRC_CR_REV_OUT          (1UL << 7)
+#define HOST_CRC_POLY           (0x04C11DB7UL)
+
+#define DR                      Slot[HostCrcAccess()]
+
+#define RCC                     (&HostRCC)
+#define CRC                     (&HostCRC)
+/* ********************* Type definitions ( typedef ) *************************/
+typedef struct
+{
+    uint32_t AHBENR;
+}RCC_TypeDef;
+
+typedef struct
+{
+    uint32_t Slot[1];   /**< CRC->DR, written or read by the current access */
+    uint32_t CR;
+    uint32_t INIT;
+    uint32_t Crc;       /**< Register of the unit before REV_OUT             */
+    uint32_t Accesses;  /**< Accesses of CRC->DR, clear to load INIT          */
+}CRC_TypeDef;
+/* ***************** Global data declarations ( extern ) **********************/
+static RCC_TypeDef HostRCC;
+static CRC_TypeDef HostCRC;
+
+/******************************************************************************/
+/**
+* uint32_t HostCrcReverse(uint32_t value)
+* @brief Reverse the 32 bits of a word.
+*
+*******************************************************************************/
+static inline uint32_t HostCrcReverse(uint32_t value)
+{
+    uint32_t reversed = 0UL;
+
+    for(uint8_t i = 0U; i < 32U; i++)
+    {
+        reversed = (reversed << 1) | (value & 1UL);
+        value >>= 1;
+    }
+    return reversed;
+}
+
+/******************************************************************************/
+/**
+* uint32_t HostCrcAccess(void)
+* @brief Run the CRC unit over the word written by the previous access of
+*        CRC->DR and preset the data register with the result. A read is only
+*        expected after the last write, it is taken as a write of the result
+*        if CRC->DR is accessed again.
+*
+* @returns   index of the data register in Slot
+*
+*******************************************************************************/
+static inline uint32_t HostCrcAccess(void)
+{
+    if(HostCRC.Accesses == 0UL)
+    {
+        HostCRC.Crc = HostCRC.INIT;
+    }
+    else
+    {
+        uint32_t word = HostCRC.Slot[0];
+
+        if((HostCRC.CR & CRC_CR_REV_IN) == CRC_CR_REV_IN)
+        {
+            word = HostCrcReverse(word);
+        }
+        HostCRC.Crc ^= word;
+        for(uint8_t i = 0U; i < 32U; i++)
+        {
+            HostCRC.Crc = ((HostCRC.Crc & 0x80000000UL) != 0UL) ? ((HostCRC.Crc << 1) ^ HOST_CRC_POLY) : (HostCRC.Crc << 1);
+        }
+    }
+    HostCRC.Slot[0] = ((HostCRC.CR & CRC_CR_REV_OUT) != 0UL) ? HostCrcReverse(HostCRC.Crc) : HostCRC.Crc;
+    HostCRC.Accesses++;
+
+    return 0UL;
+}
+
+#endif
+
+/* end of stm32f0xx.h */